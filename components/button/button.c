@@ -33,7 +33,12 @@
  * MIT Licensed as described in the file LICENSE
  */
 #include "button.h"
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
 #include <esp_timer.h>
+#if !CONFIG_IDF_TARGET_ESP8266
+#include <soc/gpio_reg.h>
+#endif
 
 #define DEAD_TIME_US 50000 // 50ms
 
@@ -42,13 +47,205 @@
 #define AUTOREPEAT_INTERVAL_US (CONFIG_BUTTON_AUTOREPEAT_INTERVAL * 1000)
 #define LONG_PRESS_TIMEOUT_US  (CONFIG_BUTTON_LONG_PRESS_TIMEOUT * 1000)
 
-static button_t *buttons[CONFIG_BUTTON_MAX] = { NULL };
+#define GPIO_BIT(gpio) (1ULL << (gpio))
+
+enum {
+    REQUEST_NONE = 0,
+    REQUEST_ADD,
+    REQUEST_REMOVE,
+};
+
+typedef struct
+{
+    button_t *head;
+} button_list_t;
+
 static esp_timer_handle_t timer = NULL;
 
+// Registration requests, pushed lock-free by button_init()/button_done(), drained by the poll timer
+static button_t *requests = NULL;
+// Descriptor owning each GPIO, claimed lock-free by button_init() and released by button_done()
+static button_t *owners[GPIO_NUM_MAX] = { NULL };
+
+// Everything below is owned by the poll timer
+static button_list_t idle = { NULL };       // released buttons, not visited until their GPIO reads pressed
+static button_list_t active = { NULL };     // buttons in the middle of a gesture, visited every poll
+static button_t *by_gpio[GPIO_NUM_MAX] = { NULL };
+static uint64_t button_gpios = 0;           // GPIOs of all registered buttons
+static uint64_t high_pressed_gpios = 0;     // GPIOs of buttons pressed at high level
+static uint64_t idle_gpios = 0;             // GPIOs of the buttons in the idle list
+
 #define CHECK(x) do { esp_err_t __; if ((__ = x) != ESP_OK) return __; } while (0)
 #define CHECK_ARG(VAL) do { if (!(VAL)) return ESP_ERR_INVALID_ARG; } while (0)
 
-static void poll_button(button_t *btn)
+static void list_add(button_list_t *list, button_t *btn)
+{
+    btn->internal.prev = NULL;
+    btn->internal.next = list->head;
+    if (list->head)
+        list->head->internal.prev = btn;
+    list->head = btn;
+}
+
+static void list_remove(button_list_t *list, button_t *btn)
+{
+    if (btn->internal.prev)
+        btn->internal.prev->internal.next = btn->internal.next;
+    else
+        list->head = btn->internal.next;
+    if (btn->internal.next)
+        btn->internal.next->internal.prev = btn->internal.prev;
+}
+
+// Sample all buttons at the same instant, bit N is set if the button on GPIO N is pressed
+static uint64_t read_pressed(void)
+{
+    uint64_t in = 0;
+#if CONFIG_IDF_TARGET_ESP8266
+    for (uint64_t gpios = button_gpios; gpios; gpios &= gpios - 1)
+        if (gpio_get_level(__builtin_ctzll(gpios)))
+            in |= gpios & -gpios;
+#else
+    in = REG_READ(GPIO_IN_REG);
+#ifdef GPIO_IN1_REG
+    in |= (uint64_t)REG_READ(GPIO_IN1_REG) << 32;
+#endif
+#endif
+    // a button is pressed when its input bit matches its pressed level
+    return ~(in ^ high_pressed_gpios) & button_gpios;
+}
+
+static void push_request(button_t *btn, uint8_t request)
+{
+    __atomic_store_n(&btn->internal.request, request, __ATOMIC_RELAXED);
+    button_t *head = __atomic_load_n(&requests, __ATOMIC_RELAXED);
+    do
+        btn->internal.pending = head;
+    while (!__atomic_compare_exchange_n(&requests, &head, btn, true, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+static void process_requests(void)
+{
+    button_t *btn = __atomic_exchange_n(&requests, NULL, __ATOMIC_ACQUIRE);
+    while (btn)
+    {
+        // done with `btn` once its request is cleared, read the link first
+        button_t *pending = btn->internal.pending;
+        uint64_t bit = GPIO_BIT(btn->gpio);
+        if (btn->internal.request == REQUEST_ADD)
+        {
+            list_add(&idle, btn);
+            by_gpio[btn->gpio] = btn;
+            button_gpios |= bit;
+            idle_gpios |= bit;
+            if (btn->pressed_level)
+                high_pressed_gpios |= bit;
+        }
+        else
+        {
+            list_remove(idle_gpios & bit ? &idle : &active, btn);
+            by_gpio[btn->gpio] = NULL;
+            button_gpios &= ~bit;
+            idle_gpios &= ~bit;
+            high_pressed_gpios &= ~bit;
+        }
+        __atomic_store_n(&btn->internal.request, REQUEST_NONE, __ATOMIC_RELEASE);
+        btn = pending;
+    }
+}
+
+#if CONFIG_BUTTON_QUEUED_EVENTS
+
+#if CONFIG_BUTTON_EVENT_QUEUE_SIZE & (CONFIG_BUTTON_EVENT_QUEUE_SIZE - 1)
+#error "CONFIG_BUTTON_EVENT_QUEUE_SIZE must be a power of two"
+#endif
+
+typedef struct
+{
+    button_t *btn;
+    button_event_t event;
+} queued_event_t;
+
+// Single producer (poll timer), single consumer (dispatcher task) ring of free running counters
+static queued_event_t queue[CONFIG_BUTTON_EVENT_QUEUE_SIZE];
+static uint32_t queue_head = 0;
+static uint32_t queue_tail = 0;
+static uint32_t queue_dropped = 0;
+static bool queue_posted = false;
+static TaskHandle_t dispatcher = NULL;
+
+static void queue_push(button_t *btn, button_state_t state, int64_t now, bool repeat)
+{
+    uint32_t head = queue_head;
+    uint32_t tail = __atomic_load_n(&queue_tail, __ATOMIC_ACQUIRE);
+    if (repeat && head != tail)
+    {
+        // the consumer is behind, fold this autorepeat click into the previous one if it's still queued
+        queued_event_t *last = &queue[(head - 1) & (CONFIG_BUTTON_EVENT_QUEUE_SIZE - 1)];
+        // a zero count means the consumer has already taken it
+        if (last->btn == btn && last->event.repeat && __atomic_fetch_add(&last->event.count, 1, __ATOMIC_RELAXED))
+            return;
+    }
+    if (head - tail == CONFIG_BUTTON_EVENT_QUEUE_SIZE)
+    {
+        __atomic_fetch_add(&queue_dropped, 1, __ATOMIC_RELAXED);
+        return;
+    }
+    queued_event_t *slot = &queue[head & (CONFIG_BUTTON_EVENT_QUEUE_SIZE - 1)];
+    slot->btn = btn;
+    slot->event.state = state;
+    slot->event.time_us = now;
+    slot->event.repeat = repeat;
+    slot->event.count = 1;
+    __atomic_store_n(&queue_head, head + 1, __ATOMIC_RELEASE);
+    queue_posted = true;
+}
+
+static void dispatch_task(void *arg)
+{
+    while (true)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        uint32_t tail = queue_tail;
+        while (tail != __atomic_load_n(&queue_head, __ATOMIC_ACQUIRE))
+        {
+            queued_event_t *slot = &queue[tail & (CONFIG_BUTTON_EVENT_QUEUE_SIZE - 1)];
+            button_t *btn = slot->btn;
+            button_event_t event = slot->event;
+            // claim the count last, the producer stops folding clicks into it from here
+            event.count = __atomic_exchange_n(&slot->event.count, 0, __ATOMIC_RELAXED);
+            __atomic_store_n(&queue_tail, ++tail, __ATOMIC_RELEASE);
+            if (btn->handler)
+                btn->handler(btn, &event);
+            else
+                btn->callback(btn, event.state);
+        }
+    }
+}
+
+#endif
+
+static void emit(button_t *btn, button_state_t state, int64_t now, bool repeat)
+{
+#if CONFIG_BUTTON_QUEUED_EVENTS
+    queue_push(btn, state, now, repeat);
+#else
+    if (btn->handler)
+    {
+        button_event_t event = {
+            .state = state,
+            .time_us = now,
+            .count = 1,
+            .repeat = repeat,
+        };
+        btn->handler(btn, &event);
+    }
+    else
+        btn->callback(btn, state);
+#endif
+}
+
+static void poll_button(button_t *btn, bool pressed, int64_t now)
 {
     if (btn->internal.state == BUTTON_PRESSED && btn->internal.pressed_time < DEAD_TIME_US)
     {
@@ -57,7 +254,7 @@ static void poll_button(button_t *btn)
         return;
     }
 
-    if (gpio_get_level(btn->gpio) == btn->pressed_level)
+    if (pressed)
     {
         // button is pressed
         if (btn->internal.state == BUTTON_RELEASED)
@@ -66,7 +263,7 @@ static void poll_button(button_t *btn)
             btn->internal.state = BUTTON_PRESSED;
             btn->internal.pressed_time = 0;
             btn->internal.repeating_time = 0;
-            btn->callback(btn, BUTTON_PRESSED);
+            emit(btn, BUTTON_PRESSED, now, false);
             return;
         }
         // increment pressing time
@@ -85,7 +282,7 @@ static void poll_button(button_t *btn)
             {
                 // reset repeating time and run callback
                 btn->internal.repeating_time = 0;
-                btn->callback(btn, BUTTON_CLICKED);
+                emit(btn, BUTTON_CLICKED, now, true);
             }
             return;
         }
@@ -94,7 +291,7 @@ static void poll_button(button_t *btn)
         {
             // button perssed long time, change state and run callback
             btn->internal.state = BUTTON_PRESSED_LONG;
-            btn->callback(btn, BUTTON_PRESSED_LONG);
+            emit(btn, BUTTON_PRESSED_LONG, now, false);
         }
     }
     else if (btn->internal.state != BUTTON_RELEASED)
@@ -102,17 +299,107 @@ static void poll_button(button_t *btn)
         // button released
         bool clicked = btn->internal.state == BUTTON_PRESSED;
         btn->internal.state = BUTTON_RELEASED;
-        btn->callback(btn, BUTTON_RELEASED);
+        emit(btn, BUTTON_RELEASED, now, false);
         if (clicked)
-            btn->callback(btn, BUTTON_CLICKED);
+            emit(btn, BUTTON_CLICKED, now, false);
     }
 }
 
+#if CONFIG_BUTTON_INTERRUPT_MODE
+
+// GPIOs with an armed edge interrupt, written by the poll timer, read by the ISR
+static volatile uint64_t armed_gpios = 0;
+
+static void arm_interrupts(bool enable)
+{
+    if (enable)
+        armed_gpios = button_gpios;
+    for (uint64_t gpios = armed_gpios; gpios; gpios &= gpios - 1)
+    {
+        if (enable)
+            gpio_intr_enable(__builtin_ctzll(gpios));
+        else
+            gpio_intr_disable(__builtin_ctzll(gpios));
+    }
+}
+
+// Not in IRAM, the GPIO ISR service is installed without ESP_INTR_FLAG_IRAM
+static void button_isr(void *arg)
+{
+    // first edge, poll until all buttons are released again
+    arm_interrupts(false);
+    esp_timer_start_periodic(timer, POLL_TIMEOUT_US);
+}
+
+#endif
+
+// Run one poll soon, so registration requests get processed while the timer sleeps
+static void kick(void)
+{
+#if CONFIG_BUTTON_INTERRUPT_MODE
+    // fails harmlessly if the timer is already running
+    esp_timer_start_once(timer, 0);
+#endif
+}
+
 static void poll(void *arg)
 {
-    for (size_t i = 0; i < CONFIG_BUTTON_MAX; i++)
-        if (buttons[i] && buttons[i]->callback)
-            poll_button(buttons[i]);
+    process_requests();
+
+    uint64_t pressed = read_pressed();
+    int64_t now = esp_timer_get_time();
+
+    // idle buttons reading pressed start a gesture, idle ones reading released cost nothing
+    for (uint64_t started = pressed & idle_gpios; started; started &= started - 1)
+    {
+        button_t *btn = by_gpio[__builtin_ctzll(started)];
+        list_remove(&idle, btn);
+        list_add(&active, btn);
+        idle_gpios &= ~GPIO_BIT(btn->gpio);
+    }
+
+    button_t *next;
+    for (button_t *btn = active.head; btn; btn = next)
+    {
+        next = btn->internal.next;
+        if (btn->callback || btn->handler)
+            poll_button(btn, pressed & GPIO_BIT(btn->gpio), now);
+        if (btn->internal.state == BUTTON_RELEASED)
+        {
+            list_remove(&active, btn);
+            list_add(&idle, btn);
+            idle_gpios |= GPIO_BIT(btn->gpio);
+        }
+    }
+
+#if CONFIG_BUTTON_QUEUED_EVENTS
+    // one wake up of the dispatcher per poll, however many events it produced
+    if (queue_posted)
+    {
+        queue_posted = false;
+        xTaskNotifyGive(dispatcher);
+    }
+#endif
+
+#if CONFIG_BUTTON_INTERRUPT_MODE
+    if (active.head)
+    {
+        // woken by kick(), keep polling
+        if (!esp_timer_is_active(timer))
+            esp_timer_start_periodic(timer, POLL_TIMEOUT_US);
+        return;
+    }
+
+    // all released, sleep until the next edge
+    esp_timer_stop(timer);
+    arm_interrupts(true);
+    // a button pressed before the interrupts were armed made no edge, catch it here
+    if (read_pressed())
+    {
+        arm_interrupts(false);
+        esp_timer_start_periodic(timer, POLL_TIMEOUT_US);
+    }
+#endif
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -124,59 +411,113 @@ static const esp_timer_create_args_t timer_args = {
     .callback = poll,
 };
 
+#if CONFIG_BUTTON_QUEUED_EVENTS || !CONFIG_BUTTON_INTERRUPT_MODE
+// Undo a partial setup of the poll timer, the next button_init() starts over
+static esp_err_t poll_setup_failed(esp_err_t res)
+{
+#if CONFIG_BUTTON_QUEUED_EVENTS
+    if (dispatcher)
+    {
+        vTaskDelete(dispatcher);
+        dispatcher = NULL;
+    }
+#endif
+    esp_timer_delete(timer);
+    timer = NULL;
+    return res;
+}
+#endif
+
 esp_err_t button_init(button_t *btn)
 {
-    CHECK_ARG(btn);
+    CHECK_ARG(btn && btn->gpio >= 0 && btn->gpio < GPIO_NUM_MAX);
 
     if (!timer)
+    {
         CHECK(esp_timer_create(&timer_args, &timer));
+#if CONFIG_BUTTON_QUEUED_EVENTS
+        if (xTaskCreate(dispatch_task, "buttons", CONFIG_BUTTON_TASK_STACK_SIZE, NULL,
+                        CONFIG_BUTTON_TASK_PRIORITY, &dispatcher) != pdPASS)
+            return poll_setup_failed(ESP_ERR_NO_MEM);
+#endif
+#if !CONFIG_BUTTON_INTERRUPT_MODE
+        // runs for good, buttons come and go without touching it
+        esp_err_t start_res = esp_timer_start_periodic(timer, POLL_TIMEOUT_US);
+        if (start_res != ESP_OK)
+            return poll_setup_failed(start_res);
+#endif
+    }
 
-    esp_timer_stop(timer);
+#if CONFIG_BUTTON_INTERRUPT_MODE
+    esp_err_t isr_res = gpio_install_isr_service(0);
+    if (isr_res != ESP_OK && isr_res != ESP_ERR_INVALID_STATE)
+        return isr_res;
+#endif
 
-    esp_err_t res = ESP_ERR_NO_MEM;
+    button_t *owner = NULL;
+    if (!__atomic_compare_exchange_n(&owners[btn->gpio], &owner, btn, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        return ESP_ERR_INVALID_STATE;
 
-    for (size_t i = 0; i < CONFIG_BUTTON_MAX; i++)
+    btn->internal.state = BUTTON_RELEASED;
+    btn->internal.pressed_time = 0;
+    btn->internal.repeating_time = 0;
+    esp_err_t res = gpio_set_direction(btn->gpio, GPIO_MODE_INPUT);
+    if (res == ESP_OK && btn->internal_pull)
+        res = gpio_set_pull_mode(btn->gpio, btn->pressed_level ? GPIO_PULLDOWN_ONLY : GPIO_PULLUP_ONLY);
+#if CONFIG_BUTTON_INTERRUPT_MODE
+    if (res == ESP_OK)
+        res = gpio_set_intr_type(btn->gpio, GPIO_INTR_ANYEDGE);
+    if (res == ESP_OK)
+        res = gpio_isr_handler_add(btn->gpio, button_isr, NULL);
+    if (res == ESP_OK)
+        gpio_intr_disable(btn->gpio);
+#endif
+    if (res != ESP_OK)
     {
-        if (buttons[i] == btn)
-            break;
-
-        if (!buttons[i])
-        {
-            btn->internal.state = BUTTON_RELEASED;
-            btn->internal.pressed_time = 0;
-            btn->internal.repeating_time = 0;
-            res = gpio_set_direction(btn->gpio, GPIO_MODE_INPUT);
-            if (res != ESP_OK) break;
-            if (btn->internal_pull)
-            {
-                res = gpio_set_pull_mode(btn->gpio, btn->pressed_level ? GPIO_PULLDOWN_ONLY : GPIO_PULLUP_ONLY);
-                if (res != ESP_OK) break;
-            }
-            buttons[i] = btn;
-            break;
-        }
+        __atomic_store_n(&owners[btn->gpio], NULL, __ATOMIC_RELAXED);
+        return res;
     }
 
-    CHECK(esp_timer_start_periodic(timer, POLL_TIMEOUT_US));
-    return res;
+    push_request(btn, REQUEST_ADD);
+    kick();
+    return ESP_OK;
 }
 
 esp_err_t button_done(button_t *btn)
 {
-    CHECK_ARG(btn);
+    CHECK_ARG(btn && btn->gpio >= 0 && btn->gpio < GPIO_NUM_MAX);
 
-    esp_timer_stop(timer);
+    // only the registered descriptor itself, not a copy or another one on the same GPIO
+    if (__atomic_load_n(&owners[btn->gpio], __ATOMIC_RELAXED) != btn || btn->internal.request == REQUEST_REMOVE)
+        return ESP_ERR_INVALID_ARG;
 
-    esp_err_t res = ESP_ERR_INVALID_ARG;
+    // the descriptor may be freed once this returns, wait for the poll timer to let go of it
+    while (__atomic_load_n(&btn->internal.request, __ATOMIC_ACQUIRE) != REQUEST_NONE)
+        vTaskDelay(1);
+    push_request(btn, REQUEST_REMOVE);
+    kick();
+    while (__atomic_load_n(&btn->internal.request, __ATOMIC_ACQUIRE) != REQUEST_NONE)
+        vTaskDelay(1);
 
-    for (size_t i = 0; i < CONFIG_BUTTON_MAX; i++)
-        if (buttons[i] == btn)
-        {
-            buttons[i] = NULL;
-            res = ESP_OK;
-            break;
-        }
+#if CONFIG_BUTTON_QUEUED_EVENTS
+    // events of this button may still be queued, let the dispatcher get past them
+    uint32_t head = __atomic_load_n(&queue_head, __ATOMIC_ACQUIRE);
+    while ((int32_t)(head - __atomic_load_n(&queue_tail, __ATOMIC_ACQUIRE)) > 0)
+        vTaskDelay(1);
+#endif
+#if CONFIG_BUTTON_INTERRUPT_MODE
+    gpio_isr_handler_remove(btn->gpio);
+    gpio_set_intr_type(btn->gpio, GPIO_INTR_DISABLE);
+#endif
+    __atomic_store_n(&owners[btn->gpio], NULL, __ATOMIC_RELAXED);
+    return ESP_OK;
+}
 
-    CHECK(esp_timer_start_periodic(timer, POLL_TIMEOUT_US));
-    return res;
+uint32_t button_dropped_events(void)
+{
+#if CONFIG_BUTTON_QUEUED_EVENTS
+    return __atomic_load_n(&queue_dropped, __ATOMIC_RELAXED);
+#else
+    return 0;
+#endif
 }
@@ -69,6 +69,25 @@ typedef enum {
  */
 typedef void (*button_event_cb_t)(button_t *btn, button_state_t state);
 
+/**
+ * Button event with its details
+ */
+typedef struct
+{
+    button_state_t state;           //!< Button action (new state)
+    int64_t time_us;                //!< Time of the poll which detected it, us since boot, of the first one if coalesced
+    uint32_t count;                 //!< Number of autorepeat clicks coalesced into this event, 1 for any other event
+    bool repeat;                    //!< `BUTTON_CLICKED` sent by autorepeat
+} button_event_t;
+
+/**
+ * Detailed callback prototype
+ *
+ * @param btn    Pointer to button descriptor
+ * @param event  Event details, only valid during the call
+ */
+typedef void (*button_event_handler_t)(button_t *btn, const button_event_t *event);
+
 /**
  * Button descriptor struct
  */
@@ -79,30 +98,52 @@ struct button_s
     uint8_t pressed_level;          //!< Logic level of pressed button
     bool autorepeat;                //!< Enable autorepeat
     button_event_cb_t callback;     //!< Button callback
+    button_event_handler_t handler; //!< Detailed button callback, called instead of `callback` if set
     void *ctx;                      //!< User data
     struct {
         button_state_t state;
         uint32_t pressed_time;
         uint32_t repeating_time;
+        struct button_s *next;      // idle or active list
+        struct button_s *prev;
+        struct button_s *pending;   // registration requests
+        uint8_t request;
     } internal;                     //!< Internal button state
 };
 
 /**
  * @brief Init button
  *
- * @param btn Pointer to button descriptor
- * @return `ESP_OK` on success
+ * Any number of buttons can be registered, one per GPIO. Registration never
+ * stops the poll timer, the button is picked up by the next poll.
+ *
+ * @param btn Pointer to button descriptor, must stay valid until button_done()
+ * @return `ESP_OK` on success, `ESP_ERR_INVALID_STATE` if the GPIO already has a button
  */
 esp_err_t button_init(button_t *btn);
 
 /**
  * @brief Deinit button
  *
- * @param btn Pointer to button descriptor
- * @return `ESP_OK` on success
+ * Waits for the next poll to drop the button, so it can't be called from a
+ * button callback.
+ *
+ * @param btn Pointer to button descriptor passed to button_init()
+ * @return `ESP_OK` on success, `ESP_ERR_INVALID_ARG` if `btn` is not a registered
+ *         descriptor (never registered, already deinited, or a copy of one)
  */
 esp_err_t button_done(button_t *btn);
 
+/**
+ * @brief Number of events dropped because the event queue was full
+ *
+ * Always 0 unless CONFIG_BUTTON_QUEUED_EVENTS is set. Autorepeat clicks are
+ * coalesced before anything is dropped.
+ *
+ * @return Number of events dropped since boot
+ */
+uint32_t button_dropped_events(void);
+
 #ifdef __cplusplus
 }
 #endif
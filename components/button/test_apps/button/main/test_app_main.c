@@ -0,0 +1,14 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include <stdio.h>
+#include "unity.h"
+#include "sdkconfig.h"
+
+void app_main(void)
+{
+    printf("Button test app\n");
+
+    unity_run_menu();
+}
@@ -0,0 +1,49 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include "unity.h"
+#include "button.h"
+
+#define TEST_BUTTON_GPIO GPIO_NUM_4
+
+static void ignore_event(button_t *btn, button_state_t state)
+{
+}
+
+static button_t test_button(void)
+{
+    button_t btn = {
+        .gpio = TEST_BUTTON_GPIO,
+        .internal_pull = true,
+        .pressed_level = 0,
+        .callback = ignore_event,
+    };
+    return btn;
+}
+
+TEST_CASE("button_done rejects a descriptor that was never registered", "[button]")
+{
+    button_t btn = test_button();
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, button_done(&btn));
+}
+
+TEST_CASE("button_done leaves the registered button alone", "[button]")
+{
+    button_t btn = test_button();
+    TEST_ESP_OK(button_init(&btn));
+
+    // neither a copy nor another descriptor on the same GPIO owns it
+    button_t copy = btn;
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, button_done(&copy));
+    button_t other = test_button();
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, button_done(&other));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, button_init(&other));
+
+    TEST_ESP_OK(button_done(&btn));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, button_done(&btn));
+
+    // the GPIO is free again
+    TEST_ESP_OK(button_init(&other));
+    TEST_ESP_OK(button_done(&other));
+}
@@ -0,0 +1,9 @@
+# SPDX-License-Identifier: CC0-1.0
+import pytest
+from pytest_embedded_idf import IdfDut
+
+
+@pytest.mark.esp32s2
+@pytest.mark.generic
+def test_button(dut: IdfDut) -> None:
+    dut.run_all_single_board_cases()
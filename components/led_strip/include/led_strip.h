@@ -0,0 +1,210 @@
+/*
+ * SPDX-FileCopyrightText: 2022-2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "led_strip_rmt.h"
+#include "led_strip_spi.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Set RGB for a specific pixel
+ *
+ * @param strip: LED strip
+ * @param index: index of pixel to set
+ * @param red: red part of color
+ * @param green: green part of color
+ * @param blue: blue part of color
+ *
+ * @return
+ *      - ESP_OK: Set RGB for a specific pixel successfully
+ *      - ESP_ERR_INVALID_ARG: Set RGB for a specific pixel failed because of invalid parameters
+ *      - ESP_ERR_NOT_SUPPORTED: The strip has no pixel buffer, see `led_strip_new_rmt_stream_device`
+ *      - ESP_FAIL: Set RGB for a specific pixel failed because other error occurred
+ */
+esp_err_t led_strip_set_pixel(led_strip_handle_t strip, uint32_t index, uint32_t red, uint32_t green, uint32_t blue);
+
+/**
+ * @brief Set RGBW for a specific pixel
+ *
+ * @note Only call this function if your led strip does have the white component (e.g. SK6812-RGBW)
+ * @note Also see `led_strip_set_pixel` if you only want to specify the RGB part of the color and bypass the white component
+ *
+ * @param strip: LED strip
+ * @param index: index of pixel to set
+ * @param red: red part of color
+ * @param green: green part of color
+ * @param blue: blue part of color
+ * @param white: separate white component
+ *
+ * @return
+ *      - ESP_OK: Set RGBW color for a specific pixel successfully
+ *      - ESP_ERR_INVALID_ARG: Set RGBW color for a specific pixel failed because of an invalid argument
+ *      - ESP_FAIL: Set RGBW color for a specific pixel failed because other error occurred
+ */
+esp_err_t led_strip_set_pixel_rgbw(led_strip_handle_t strip, uint32_t index, uint32_t red, uint32_t green, uint32_t blue, uint32_t white);
+
+/**
+ * @brief Set RGB for a span of pixels
+ *
+ * @note The white component of RGBW strips is set to 0, as with `led_strip_set_pixel`
+ *
+ * @param strip: LED strip
+ * @param start: index of the first pixel to set
+ * @param count: number of pixels to set
+ * @param colors: `count` colors, the first one goes to pixel `start`
+ *
+ * @return
+ *      - ESP_OK: Set the pixels successfully
+ *      - ESP_ERR_INVALID_ARG: Invalid argument, or the span doesn't fit in the strip
+ *      - ESP_ERR_NOT_SUPPORTED: The backend only sets one pixel at a time
+ */
+esp_err_t led_strip_set_pixels(led_strip_handle_t strip, uint32_t start, uint32_t count, const led_strip_rgb_t *colors);
+
+/**
+ * @brief Set a span of pixels from bytes already in the color component order of the strip
+ *
+ * @note Each pixel takes as many bytes as the strip has color components, e.g. G, R, B for `LED_STRIP_COLOR_COMPONENT_FMT_GRB`.
+ *       The bytes are copied as they are, this is the fastest way to update a whole strip.
+ *
+ * @param strip: LED strip
+ * @param start: index of the first pixel to set
+ * @param count: number of pixels to set
+ * @param data: `count` pixels, the first one goes to pixel `start`
+ *
+ * @return
+ *      - ESP_OK: Set the pixels successfully
+ *      - ESP_ERR_INVALID_ARG: Invalid argument, or the span doesn't fit in the strip
+ *      - ESP_ERR_NOT_SUPPORTED: The backend only sets one pixel at a time
+ */
+esp_err_t led_strip_set_pixels_raw(led_strip_handle_t strip, uint32_t start, uint32_t count, const uint8_t *data);
+
+/**
+ * @brief Set HSV for a specific pixel
+ *
+ * @param strip: LED strip
+ * @param index: index of pixel to set
+ * @param hue: hue part of color (0 - 360)
+ * @param saturation: saturation part of color (0 - 255, rescaled from 0 - 1. e.g. saturation = 0.5, rescaled to 127)
+ * @param value: value part of color (0 - 255, rescaled from 0 - 1. e.g. value = 0.5, rescaled to 127)
+ *
+ * @return
+ *      - ESP_OK: Set HSV color for a specific pixel successfully
+ *      - ESP_ERR_INVALID_ARG: Set HSV color for a specific pixel failed because of an invalid argument
+ *      - ESP_FAIL: Set HSV color for a specific pixel failed because other error occurred
+ */
+esp_err_t led_strip_set_pixel_hsv(led_strip_handle_t strip, uint32_t index, uint16_t hue, uint8_t saturation, uint8_t value);
+
+/**
+ * @brief Refresh memory colors to LEDs
+ *
+ * @param strip: LED strip
+ *
+ * @return
+ *      - ESP_OK: Refresh successfully
+ *      - ESP_FAIL: Refresh failed because some other error occurred
+ *
+ * @note:
+ *      After updating the LED colors in the memory, a following invocation of this API is needed to flush colors to strip.
+ * @note:
+ *      Nothing is sent if no color changed since the last refresh, see `led_strip_get_stats`.
+ */
+esp_err_t led_strip_refresh(led_strip_handle_t strip);
+
+/**
+ * @brief Start refreshing memory colors to LEDs and return without waiting for the transfer
+ *
+ * @param strip: LED strip
+ *
+ * @return
+ *      - ESP_OK: Transfer started
+ *      - ESP_ERR_NOT_SUPPORTED: The backend only supports `led_strip_refresh`
+ *      - ESP_FAIL: Refresh failed because some other error occurred
+ *
+ * @note:
+ *      The strip keeps two frames, the one on the wire and the one being drawn. The frame being drawn keeps the pixels
+ *      just sent, so the next frame can be prepared with `led_strip_set_pixel` while the current one is sent.
+ *      If a transfer is still running, this function waits for it before starting the next one.
+ * @note:
+ *      With the RMT backend, the channel is kept enabled from the first asynchronous refresh until the strip is deleted,
+ *      which holds a power management lock and prevents light sleep.
+ */
+esp_err_t led_strip_refresh_async(led_strip_handle_t strip);
+
+/**
+ * @brief Wait for the transfer started by `led_strip_refresh_async` to finish
+ *
+ * @param strip: LED strip
+ * @param timeout_ms: Timeout value, -1 to wait forever
+ *
+ * @return
+ *      - ESP_OK: No transfer is running
+ *      - ESP_ERR_TIMEOUT: The transfer didn't finish in time
+ *      - ESP_ERR_NOT_SUPPORTED: The backend only supports `led_strip_refresh`
+ */
+esp_err_t led_strip_refresh_wait_done(led_strip_handle_t strip, int32_t timeout_ms);
+
+/**
+ * @brief Configure the gamma correction, global brightness and temporal dithering applied to the pixels on refresh
+ *
+ * @param strip: LED strip
+ * @param config: Pixel pipeline configuration
+ *
+ * @return
+ *      - ESP_OK: Pipeline configured, it applies from the next refresh
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ *      - ESP_ERR_NO_MEM: No memory for the dithering state
+ *      - ESP_ERR_NOT_SUPPORTED: The backend sends the pixels as they are set
+ *
+ * @note:
+ *      The colors set by `led_strip_set_pixel` are kept as they are, the pipeline is one table lookup per color byte on
+ *      every refresh. The table is only rebuilt when the brightness or the gamma correction changes, so dimming a strip
+ *      doesn't lose the colors set at full scale.
+ */
+esp_err_t led_strip_set_pixel_pipeline(led_strip_handle_t strip, const led_strip_pixel_pipeline_config_t *config);
+
+/**
+ * @brief Get the statistics of the LED strip
+ *
+ * @param strip: LED strip
+ * @param stats: Returned statistics
+ *
+ * @return
+ *      - ESP_OK: Statistics returned
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ *      - ESP_ERR_NOT_SUPPORTED: The backend doesn't keep statistics
+ */
+esp_err_t led_strip_get_stats(led_strip_handle_t strip, led_strip_stats_t *stats);
+
+/**
+ * @brief Clear LED strip (turn off all LEDs)
+ *
+ * @param strip: LED strip
+ *
+ * @return
+ *      - ESP_OK: Clear LEDs successfully
+ *      - ESP_FAIL: Clear LEDs failed because some other error occurred
+ */
+esp_err_t led_strip_clear(led_strip_handle_t strip);
+
+/**
+ * @brief Free LED strip resources
+ *
+ * @param strip: LED strip
+ *
+ * @return
+ *      - ESP_OK: Free resources successfully
+ *      - ESP_FAIL: Free resources failed because error occurred
+ */
+esp_err_t led_strip_del(led_strip_handle_t strip);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,161 @@
+/*
+ * SPDX-FileCopyrightText: 2022-2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "led_strip_types.h"
+#include "esp_idf_version.h"
+#include "driver/rmt_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief LED Strip RMT specific configuration
+ */
+typedef struct {
+    rmt_clock_source_t clk_src; /*!< RMT clock source */
+    uint32_t resolution_hz;     /*!< RMT tick resolution, if set to zero, a default resolution (10MHz) will be applied */
+    size_t mem_block_symbols;   /*!< How many RMT symbols can one RMT channel hold at one time. Set to 0 will fallback to use the default size. */
+    /*!< Extra RMT specific driver flags */
+    struct led_strip_rmt_extra_config {
+        uint32_t with_dma: 1;   /*!< Use DMA to transmit data */
+    } flags;                    /*!< Extra driver flags */
+} led_strip_rmt_config_t;
+
+/**
+ * @brief Create LED strip based on RMT TX channel
+ *
+ * @param led_config LED strip configuration
+ * @param rmt_config RMT specific configuration
+ * @param ret_strip Returned LED strip handle
+ * @return
+ *      - ESP_OK: create LED strip handle successfully
+ *      - ESP_ERR_INVALID_ARG: create LED strip handle failed because of invalid argument
+ *      - ESP_ERR_NO_MEM: create LED strip handle failed because of out of memory
+ *      - ESP_FAIL: create LED strip handle failed because some other error
+ */
+esp_err_t led_strip_new_rmt_device(const led_strip_config_t *led_config, const led_strip_rmt_config_t *rmt_config, led_strip_handle_t *ret_strip);
+
+/**
+ * @brief Generate a span of pixels of a streamed LED strip
+ *
+ * @note Called from the RMT ISR while the frame is sent, it must be quick or the RMT runs out of symbols and the LEDs latch early.
+ *       With `CONFIG_RMT_ISR_IRAM_SAFE`, the generator and the data it reads must be in internal RAM.
+ *
+ * @param start Index of the first pixel
+ * @param count Number of pixels
+ * @param pixels Room for `count` pixels, each is as many bytes as the strip has color components, in the color component order of the strip
+ * @param user_ctx User context given in the stream configuration
+ */
+typedef void (*led_strip_rmt_pixel_generator_t)(uint32_t start, uint32_t count, uint8_t *pixels, void *user_ctx);
+
+/**
+ * @brief LED Strip RMT streaming configuration
+ */
+typedef struct {
+    led_strip_rmt_pixel_generator_t generator; /*!< Generates the pixels of each frame as it is sent */
+    void *user_ctx;                            /*!< User context passed to the generator */
+    uint32_t chunk_pixels;                     /*!< Pixels generated at once, the only pixel memory of the strip. Set to 0 to use the default (16) */
+} led_strip_rmt_stream_config_t;
+
+/**
+ * @brief Create LED strip based on RMT TX channel, whose pixels are generated as they are sent instead of kept in memory
+ *
+ * @note Meant for long strips drawn by procedural effects. Every refresh sends a new frame pulled from the generator,
+ *       `led_strip_clear` sends a dark frame without calling it.
+ * @note The strip has no pixel buffer: `led_strip_set_pixel` and the pixel pipeline are not supported.
+ *
+ * @param led_config LED strip configuration
+ * @param rmt_config RMT specific configuration
+ * @param stream_config Streaming configuration
+ * @param ret_strip Returned LED strip handle
+ * @return
+ *      - ESP_OK: create LED strip handle successfully
+ *      - ESP_ERR_INVALID_ARG: create LED strip handle failed because of invalid argument
+ *      - ESP_ERR_NO_MEM: create LED strip handle failed because of out of memory
+ *      - ESP_FAIL: create LED strip handle failed because some other error
+ */
+esp_err_t led_strip_new_rmt_stream_device(const led_strip_config_t *led_config, const led_strip_rmt_config_t *rmt_config,
+                                          const led_strip_rmt_stream_config_t *stream_config, led_strip_handle_t *ret_strip);
+
+/**
+ * @brief Type of RMT LED strip group handle
+ */
+typedef struct led_strip_rmt_group_t *led_strip_rmt_group_handle_t;
+
+/**
+ * @brief Group RMT LED strips, so that their frames start in the same clock cycle and are sent in parallel
+ *
+ * @note Refreshing any strip of the group refreshes all of them, a frame takes as long as the longest strip.
+ * @note The RMT channels of the strips are enabled and kept enabled, which holds a power management lock and prevents light sleep.
+ * @note Only available on targets whose RMT supports TX synchronization.
+ *
+ * @param strips RMT LED strips, up to the number of RMT TX channels
+ * @param nr_strips Number of strips
+ * @param ret_group Returned group handle
+ * @return
+ *      - ESP_OK: create the group successfully
+ *      - ESP_ERR_INVALID_ARG: create the group failed because of invalid argument, e.g. a strip not driven by RMT
+ *      - ESP_ERR_INVALID_STATE: create the group failed because a strip is already in a group
+ *      - ESP_ERR_NO_MEM: create the group failed because of out of memory
+ *      - ESP_ERR_NOT_SUPPORTED: create the group failed because the RMT of this target can't synchronize its channels
+ */
+esp_err_t led_strip_rmt_new_group(const led_strip_handle_t *strips, size_t nr_strips, led_strip_rmt_group_handle_t *ret_group);
+
+/**
+ * @brief Start sending the frames of all the strips of a group together, without waiting for the transfer
+ *
+ * @note Nothing is sent if no strip changed since the last refresh. If any did, every strip is sent.
+ *
+ * @param group Strip group
+ * @return
+ *      - ESP_OK: Transfer started
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ *      - ESP_FAIL: Refresh failed because some other error occurred
+ */
+esp_err_t led_strip_rmt_group_refresh_async(led_strip_rmt_group_handle_t group);
+
+/**
+ * @brief Wait for the last strip of the group to be sent
+ *
+ * @param group Strip group
+ * @param timeout_ms Timeout value, -1 to wait forever
+ * @return
+ *      - ESP_OK: No transfer is running
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ *      - ESP_ERR_TIMEOUT: The transfer didn't finish in time
+ */
+esp_err_t led_strip_rmt_group_wait_done(led_strip_rmt_group_handle_t group, int32_t timeout_ms);
+
+/**
+ * @brief Send the frames of all the strips of a group together, and wait for the last one
+ *
+ * @param group Strip group
+ * @return
+ *      - ESP_OK: Refresh successfully
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ *      - ESP_FAIL: Refresh failed because some other error occurred
+ */
+esp_err_t led_strip_rmt_group_refresh(led_strip_rmt_group_handle_t group);
+
+/**
+ * @brief Delete a strip group, its strips are refreshed on their own again
+ *
+ * @note The strips of a group can only be deleted once the group is deleted
+ *
+ * @param group Strip group
+ * @return
+ *      - ESP_OK: Delete the group successfully
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ */
+esp_err_t led_strip_rmt_del_group(led_strip_rmt_group_handle_t group);
+
+#ifdef __cplusplus
+}
+#endif
@@ -48,6 +48,15 @@ typedef union {
 #define LED_STRIP_COLOR_COMPONENT_FMT_RGB (led_color_component_format_t){.format = {.r_pos = 0, .g_pos = 1, .b_pos = 2, .w_pos = 3, .reserved = 0, .num_components = 3}}
 #define LED_STRIP_COLOR_COMPONENT_FMT_RGBW (led_color_component_format_t){.format = {.r_pos = 0, .g_pos = 1, .b_pos = 2, .w_pos = 3, .reserved = 0, .num_components = 4}}
 
+/**
+ * @brief RGB color of one pixel, as taken by `led_strip_set_pixels`
+ */
+typedef struct {
+    uint8_t red;   /*!< Red part of color */
+    uint8_t green; /*!< Green part of color */
+    uint8_t blue;  /*!< Blue part of color */
+} led_strip_rgb_t;
+
 /**
  * @brief LED Strip common configurations
  *        The common configurations are not specific to any backend peripheral.
@@ -64,6 +73,27 @@ typedef struct {
     } flags; /*!< Extra driver flags */
 } led_strip_config_t;
 
+/**
+ * @brief LED strip pixel pipeline configuration, applied to every pixel on refresh
+ */
+typedef struct {
+    uint8_t brightness;       /*!< Global brightness, 0~255, applied after the gamma correction */
+    /*!< Pixel pipeline flags */
+    struct led_strip_pixel_pipeline_flags {
+        uint32_t gamma: 1;    /*!< Apply a gamma 2.2 correction, so that color values look evenly spaced */
+        uint32_t dither: 1;   /*!< Spread the rounding error of each color over the following frames, smooths slow fades at low levels.
+                                   Only has an effect if the strip is refreshed continuously */
+    } flags;                  /*!< Pixel pipeline flags */
+} led_strip_pixel_pipeline_config_t;
+
+/**
+ * @brief LED strip statistics
+ */
+typedef struct {
+    uint32_t refreshes;         /*!< Frames sent to the LEDs */
+    uint32_t skipped_refreshes; /*!< Refreshes skipped because no pixel changed since the last frame sent */
+} led_strip_stats_t;
+
 #ifdef __cplusplus
 }
 #endif
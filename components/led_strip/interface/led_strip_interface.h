@@ -0,0 +1,194 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "led_strip_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct led_strip_t led_strip_t; /*!< Type of LED strip */
+
+/**
+ * @brief LED strip interface definition
+ */
+struct led_strip_t {
+    /**
+     * @brief Set RGB for a specific pixel
+     *
+     * @param strip: LED strip
+     * @param index: index of pixel to set
+     * @param red: red part of color
+     * @param green: green part of color
+     * @param blue: blue part of color
+     *
+     * @return
+     *      - ESP_OK: Set RGB for a specific pixel successfully
+     *      - ESP_ERR_INVALID_ARG: Set RGB for a specific pixel failed because of invalid parameters
+     *      - ESP_FAIL: Set RGB for a specific pixel failed because other error occurred
+     *
+     * @note:
+     *      NULL if the backend has no pixel buffer, e.g. a strip whose frames are generated as they are sent.
+     */
+    esp_err_t (*set_pixel)(led_strip_t *strip, uint32_t index, uint32_t red, uint32_t green, uint32_t blue);
+
+    /**
+     * @brief Set RGBW for a specific pixel. Similar to `set_pixel` but also set the white component
+     *
+     * @param strip: LED strip
+     * @param index: index of pixel to set
+     * @param red: red part of color
+     * @param green: green part of color
+     * @param blue: blue part of color
+     * @param white: separate white component
+     *
+     * @return
+     *      - ESP_OK: Set RGBW color for a specific pixel successfully
+     *      - ESP_ERR_INVALID_ARG: Set RGBW color for a specific pixel failed because of an invalid argument
+     *      - ESP_FAIL: Set RGBW color for a specific pixel failed because other error occurred
+     *
+     * @note:
+     *      NULL if `set_pixel` is NULL.
+     */
+    esp_err_t (*set_pixel_rgbw)(led_strip_t *strip, uint32_t index, uint32_t red, uint32_t green, uint32_t blue, uint32_t white);
+
+    /**
+     * @brief Set RGB for a span of pixels
+     *
+     * @param strip: LED strip
+     * @param start: index of the first pixel to set
+     * @param count: number of pixels to set
+     * @param colors: `count` colors
+     *
+     * @return
+     *      - ESP_OK: Set the pixels successfully
+     *      - ESP_ERR_INVALID_ARG: The span doesn't fit in the strip
+     *
+     * @note:
+     *      Optional, NULL if the backend only sets one pixel at a time.
+     *      The white component of RGBW pixels is set to 0, as in `set_pixel`.
+     */
+    esp_err_t (*set_pixels)(led_strip_t *strip, uint32_t start, uint32_t count, const led_strip_rgb_t *colors);
+
+    /**
+     * @brief Set a span of pixels from bytes already in the color component order of the strip
+     *
+     * @param strip: LED strip
+     * @param start: index of the first pixel to set
+     * @param count: number of pixels to set
+     * @param data: `count` pixels of 3 or 4 bytes, as many as the strip has color components
+     *
+     * @return
+     *      - ESP_OK: Set the pixels successfully
+     *      - ESP_ERR_INVALID_ARG: The span doesn't fit in the strip
+     *
+     * @note:
+     *      Optional, NULL if the backend only sets one pixel at a time.
+     */
+    esp_err_t (*set_pixels_raw)(led_strip_t *strip, uint32_t start, uint32_t count, const uint8_t *data);
+
+    /**
+     * @brief Refresh memory colors to LEDs
+     *
+     * @param strip: LED strip
+     * @param timeout_ms: timeout value for refreshing task
+     *
+     * @return
+     *      - ESP_OK: Refresh successfully
+     *      - ESP_FAIL: Refresh failed because some other error occurred
+     *
+     * @note:
+     *      After updating the LED colors in the memory, a following invocation of this API is needed to flush colors to strip.
+     *      Backends should skip the transfer if no color changed since the last one, and count it in their statistics.
+     */
+    esp_err_t (*refresh)(led_strip_t *strip);
+
+    /**
+     * @brief Start flushing memory colors to LEDs, without waiting for the transfer to finish
+     *
+     * @param strip: LED strip
+     *
+     * @return
+     *      - ESP_OK: Transfer started
+     *      - ESP_FAIL: Refresh failed because some other error occurred
+     *
+     * @note:
+     *      Optional, NULL if the backend only supports blocking refreshes.
+     *      Pixels set afterwards go to the next frame, the frame on the wire is not changed.
+     */
+    esp_err_t (*refresh_async)(led_strip_t *strip);
+
+    /**
+     * @brief Wait for the transfer started by `refresh_async` to finish
+     *
+     * @param strip: LED strip
+     * @param timeout_ms: timeout value, -1 to wait forever
+     *
+     * @return
+     *      - ESP_OK: No transfer is running
+     *      - ESP_ERR_TIMEOUT: The transfer didn't finish in time
+     *
+     * @note:
+     *      Optional, NULL if `refresh_async` is NULL.
+     */
+    esp_err_t (*refresh_wait_done)(led_strip_t *strip, int32_t timeout_ms);
+
+    /**
+     * @brief Configure the gamma correction, brightness and dithering applied on refresh
+     *
+     * @param strip: LED strip
+     * @param config: pixel pipeline configuration
+     *
+     * @return
+     *      - ESP_OK: Pipeline configured
+     *      - ESP_ERR_NO_MEM: No memory for the dithering state
+     *
+     * @note:
+     *      Optional, NULL if the backend sends the pixels as they are set.
+     */
+    esp_err_t (*set_pixel_pipeline)(led_strip_t *strip, const led_strip_pixel_pipeline_config_t *config);
+
+    /**
+     * @brief Get the statistics of the LED strip
+     *
+     * @param strip: LED strip
+     * @param stats: returned statistics
+     *
+     * @return
+     *      - ESP_OK: Statistics returned
+     */
+    esp_err_t (*get_stats)(led_strip_t *strip, led_strip_stats_t *stats);
+
+    /**
+     * @brief Clear LED strip (turn off all LEDs)
+     *
+     * @param strip: LED strip
+     * @param timeout_ms: timeout value for clearing task
+     *
+     * @return
+     *      - ESP_OK: Clear LEDs successfully
+     *      - ESP_FAIL: Clear LEDs failed because some other error occurred
+     */
+    esp_err_t (*clear)(led_strip_t *strip);
+
+    /**
+     * @brief Free LED strip resources
+     *
+     * @param strip: LED strip
+     *
+     * @return
+     *      - ESP_OK: Free resources successfully
+     *      - ESP_FAIL: Free resources failed because error occurred
+     */
+    esp_err_t (*del)(led_strip_t *strip);
+};
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,67 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "led_strip_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Pixel pipeline, turns the color bytes set by the user into the bytes sent to the LEDs
+ *
+ * @note Backends keep the user's bytes untouched and run the pipeline on every refresh,
+ *       so that dithering can spread the rounding error of a color over the following frames.
+ */
+typedef struct {
+    led_strip_pixel_pipeline_config_t config; /*!< Current configuration */
+    bool identity;                            /*!< The pipeline doesn't change any byte */
+    uint16_t lut[256];                        /*!< Output of each input byte, 8.8 fixed point */
+    uint8_t *residual;                        /*!< Fraction left over by the previous frame for each byte, NULL if dithering is off */
+    size_t size;                              /*!< Number of bytes in a frame */
+} led_strip_pixel_pipeline_t;
+
+/**
+ * @brief Set up a pipeline which leaves the bytes as they are
+ *
+ * @param[in] pipeline Pipeline
+ * @param[in] size Number of bytes in a frame
+ */
+void led_strip_pixel_pipeline_init(led_strip_pixel_pipeline_t *pipeline, size_t size);
+
+/**
+ * @brief Configure the pipeline, the lookup table is only rebuilt if the brightness or the gamma correction changes
+ *
+ * @param[in] pipeline Pipeline
+ * @param[in] config New configuration
+ * @return
+ *      - ESP_OK: Pipeline configured
+ *      - ESP_ERR_NO_MEM: No memory for the dithering residuals, the pipeline is left as it was
+ */
+esp_err_t led_strip_pixel_pipeline_config(led_strip_pixel_pipeline_t *pipeline, const led_strip_pixel_pipeline_config_t *config);
+
+/**
+ * @brief Run one frame through the pipeline, one table lookup per byte
+ *
+ * @param[in] pipeline Pipeline
+ * @param[in] in Bytes set by the user
+ * @param[out] out Bytes to send, `size` bytes
+ */
+void led_strip_pixel_pipeline_apply(led_strip_pixel_pipeline_t *pipeline, const uint8_t *in, uint8_t *out);
+
+/**
+ * @brief Free the resources of the pipeline
+ */
+void led_strip_pixel_pipeline_deinit(led_strip_pixel_pipeline_t *pipeline);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,67 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "driver/rmt_types.h"
+#include "led_strip_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Bit timings of the supported LED models, in nanoseconds
+ */
+#define LED_STRIP_WS2812_T0H_NS 300
+#define LED_STRIP_WS2812_T0L_NS 900
+#define LED_STRIP_WS2812_T1H_NS 900
+#define LED_STRIP_WS2812_T1L_NS 300
+#define LED_STRIP_SK6812_T0H_NS 300
+#define LED_STRIP_SK6812_T0L_NS 900
+#define LED_STRIP_SK6812_T1H_NS 600
+#define LED_STRIP_SK6812_T1L_NS 600
+
+/**
+ * @brief Resolution the symbol tables are built for, in Hz
+ */
+#define LED_STRIP_RMT_LUT_RESOLUTION 10000000
+
+/**
+ * @brief Duration of a bit level, in ticks of a `resolution` Hz RMT clock
+ */
+#define LED_STRIP_RMT_TICKS(resolution, ns) ((uint32_t)((uint64_t)(ns) * (resolution) / 1000000000))
+
+/**
+ * @brief RMT symbols of one byte, most significant bit first
+ */
+typedef rmt_symbol_word_t led_strip_rmt_lut_t[256][8];
+
+/**
+ * @brief Get the symbol table of a LED model
+ *
+ * @param[in] led_model LED model
+ * @param[in] resolution RMT resolution, in Hz
+ * @return
+ *      - Symbol table, built at compile time
+ *      - NULL if there's no table for this model and resolution
+ */
+const led_strip_rmt_lut_t *led_strip_rmt_lut_get(led_model_t led_model, uint32_t resolution);
+
+/**
+ * @brief Encode bytes into RMT symbols, each byte is a copy of 8 symbols from the table
+ *
+ * @param[in] lut Symbol table
+ * @param[in] data Bytes to encode
+ * @param[in] size Number of bytes
+ * @param[out] symbols Room for `size * 8` symbols
+ */
+void led_strip_rmt_lut_encode(const led_strip_rmt_lut_t *lut, const uint8_t *data, size_t size, rmt_symbol_word_t *symbols);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,26 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief SPI bytes sending one color byte, each color bit is 3 SPI bits: 0 is 100, 1 is 110
+ */
+#define LED_STRIP_SPI_BYTES_PER_COLOR_BYTE 3
+
+/**
+ * @brief SPI patterns of all the color bytes, most significant bit first, built at compile time
+ */
+extern const uint8_t led_strip_spi_lut[256][LED_STRIP_SPI_BYTES_PER_COLOR_BYTE];
+
+#ifdef __cplusplus
+}
+#endif
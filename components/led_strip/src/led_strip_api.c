@@ -13,12 +13,14 @@ static const char *TAG = "led_strip";
 esp_err_t led_strip_set_pixel(led_strip_handle_t strip, uint32_t index, uint32_t red, uint32_t green, uint32_t blue)
 {
     ESP_RETURN_ON_FALSE(strip, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(strip->set_pixel, ESP_ERR_NOT_SUPPORTED, TAG, "setting pixels not supported");
     return strip->set_pixel(strip, index, red, green, blue);
 }
 
 esp_err_t led_strip_set_pixel_hsv(led_strip_handle_t strip, uint32_t index, uint16_t hue, uint8_t saturation, uint8_t value)
 {
     ESP_RETURN_ON_FALSE(strip, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(strip->set_pixel, ESP_ERR_NOT_SUPPORTED, TAG, "setting pixels not supported");
 
     uint32_t red = 0;
     uint32_t green = 0;
@@ -72,15 +74,58 @@ esp_err_t led_strip_set_pixel_hsv(led_strip_handle_t strip, uint32_t index, uint
 esp_err_t led_strip_set_pixel_rgbw(led_strip_handle_t strip, uint32_t index, uint32_t red, uint32_t green, uint32_t blue, uint32_t white)
 {
     ESP_RETURN_ON_FALSE(strip, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(strip->set_pixel_rgbw, ESP_ERR_NOT_SUPPORTED, TAG, "setting pixels not supported");
     return strip->set_pixel_rgbw(strip, index, red, green, blue, white);
 }
 
+esp_err_t led_strip_set_pixels(led_strip_handle_t strip, uint32_t start, uint32_t count, const led_strip_rgb_t *colors)
+{
+    ESP_RETURN_ON_FALSE(strip && (colors || !count), ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(strip->set_pixels, ESP_ERR_NOT_SUPPORTED, TAG, "setting pixel spans not supported");
+    return strip->set_pixels(strip, start, count, colors);
+}
+
+esp_err_t led_strip_set_pixels_raw(led_strip_handle_t strip, uint32_t start, uint32_t count, const uint8_t *data)
+{
+    ESP_RETURN_ON_FALSE(strip && (data || !count), ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(strip->set_pixels_raw, ESP_ERR_NOT_SUPPORTED, TAG, "setting pixel spans not supported");
+    return strip->set_pixels_raw(strip, start, count, data);
+}
+
 esp_err_t led_strip_refresh(led_strip_handle_t strip)
 {
     ESP_RETURN_ON_FALSE(strip, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
     return strip->refresh(strip);
 }
 
+esp_err_t led_strip_refresh_async(led_strip_handle_t strip)
+{
+    ESP_RETURN_ON_FALSE(strip, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(strip->refresh_async, ESP_ERR_NOT_SUPPORTED, TAG, "asynchronous refresh not supported");
+    return strip->refresh_async(strip);
+}
+
+esp_err_t led_strip_refresh_wait_done(led_strip_handle_t strip, int32_t timeout_ms)
+{
+    ESP_RETURN_ON_FALSE(strip, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(strip->refresh_wait_done, ESP_ERR_NOT_SUPPORTED, TAG, "asynchronous refresh not supported");
+    return strip->refresh_wait_done(strip, timeout_ms);
+}
+
+esp_err_t led_strip_set_pixel_pipeline(led_strip_handle_t strip, const led_strip_pixel_pipeline_config_t *config)
+{
+    ESP_RETURN_ON_FALSE(strip && config, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(strip->set_pixel_pipeline, ESP_ERR_NOT_SUPPORTED, TAG, "pixel pipeline not supported");
+    return strip->set_pixel_pipeline(strip, config);
+}
+
+esp_err_t led_strip_get_stats(led_strip_handle_t strip, led_strip_stats_t *stats)
+{
+    ESP_RETURN_ON_FALSE(strip && stats, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(strip->get_stats, ESP_ERR_NOT_SUPPORTED, TAG, "statistics not supported");
+    return strip->get_stats(strip, stats);
+}
+
 esp_err_t led_strip_clear(led_strip_handle_t strip)
 {
     ESP_RETURN_ON_FALSE(strip, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
@@ -0,0 +1,594 @@
+/*
+ * SPDX-FileCopyrightText: 2022-2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <sys/cdefs.h>
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_attr.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "driver/rmt_tx.h"
+#include "soc/soc_caps.h"
+#include "led_strip.h"
+#include "led_strip_interface.h"
+#include "led_strip_pixel_pipeline.h"
+#include "led_strip_rmt_encoder.h"
+
+#define LED_STRIP_RMT_DEFAULT_RESOLUTION 10000000 // 10MHz resolution
+#define LED_STRIP_RMT_DEFAULT_TRANS_QUEUE_SIZE 4
+#define LED_STRIP_RMT_DEFAULT_STREAM_CHUNK_PIXELS 16
+// the memory size of each RMT channel, in words (4 bytes)
+#if CONFIG_IDF_TARGET_ESP32 || CONFIG_IDF_TARGET_ESP32S2
+#define LED_STRIP_RMT_DEFAULT_MEM_BLOCK_SYMBOLS 64
+#else
+#define LED_STRIP_RMT_DEFAULT_MEM_BLOCK_SYMBOLS 48
+#endif
+
+static const char *TAG = "led_strip_rmt";
+
+typedef struct {
+    led_strip_t base;
+    rmt_channel_handle_t rmt_chan;
+    rmt_encoder_handle_t strip_encoder;
+    SemaphoreHandle_t trans_done; // given by the RMT ISR once the frame in `tx_buf` is on the wire
+    bool enabled;
+    bool keep_enabled;           // an asynchronous refresh keeps the channel enabled until the strip is deleted
+    bool busy;                   // a frame is being sent from `tx_buf`
+    bool dirty;                  // `pixel_buf` or the pipeline changed since the last frame sent
+    struct led_strip_rmt_group_t *group; // refreshed together with the other strips of the group, if not NULL
+    led_strip_stats_t stats;
+    uint32_t strip_len;
+    uint8_t bytes_per_pixel;
+    led_color_component_format_t component_fmt;
+    led_strip_pixel_pipeline_t pipeline;
+    led_strip_rmt_pixel_generator_t generator; // a streamed strip has no pixel buffer, the frame is pulled from the generator
+    void *generator_ctx;
+    bool blank;                  // a streamed strip sends a dark frame instead of calling the generator
+    uint8_t *pixel_buf;          // frame being drawn by set_pixel, as set by the user
+    uint8_t *tx_buf;             // frame being sent, out of the pixel pipeline
+    uint8_t pixel_mem[];         // both frames
+} led_strip_rmt_obj;
+
+struct led_strip_rmt_group_t {
+    rmt_sync_manager_handle_t sync_manager;
+    SemaphoreHandle_t trans_done; // given by the RMT ISR once the last strip of the group is sent
+    atomic_uint pending;          // strips still being sent
+    bool busy;                    // a frame is being sent on every channel
+    bool started;                 // the sync manager has to be reset before every frame but the first
+    size_t nr_strips;
+    led_strip_rmt_obj *strips[];
+};
+
+static bool IRAM_ATTR led_strip_rmt_on_trans_done(rmt_channel_handle_t tx_chan, const rmt_tx_done_event_data_t *edata, void *user_ctx)
+{
+    led_strip_rmt_obj *rmt_strip = (led_strip_rmt_obj *)user_ctx;
+    led_strip_rmt_group_handle_t group = rmt_strip->group;
+    BaseType_t high_task_wakeup = pdFALSE;
+    if (!group) {
+        xSemaphoreGiveFromISR(rmt_strip->trans_done, &high_task_wakeup);
+    } else if (atomic_fetch_sub(&group->pending, 1) == 1) {
+        // one event for the group, once its longest strip is sent
+        xSemaphoreGiveFromISR(group->trans_done, &high_task_wakeup);
+    }
+    return high_task_wakeup == pdTRUE;
+}
+
+static void IRAM_ATTR led_strip_rmt_stream_generate(size_t offset, uint8_t *buf, size_t size, void *user_ctx)
+{
+    led_strip_rmt_obj *rmt_strip = (led_strip_rmt_obj *)user_ctx;
+    if (rmt_strip->blank) {
+        memset(buf, 0, size);
+        return;
+    }
+    rmt_strip->generator(offset / rmt_strip->bytes_per_pixel, size / rmt_strip->bytes_per_pixel, buf, rmt_strip->generator_ctx);
+}
+
+static void led_strip_rmt_set_byte(led_strip_rmt_obj *rmt_strip, uint32_t offset, uint8_t value)
+{
+    if (rmt_strip->pixel_buf[offset] != value) {
+        rmt_strip->pixel_buf[offset] = value;
+        rmt_strip->dirty = true;
+    }
+}
+
+static esp_err_t led_strip_rmt_set_pixel(led_strip_t *strip, uint32_t index, uint32_t red, uint32_t green, uint32_t blue)
+{
+    led_strip_rmt_obj *rmt_strip = __containerof(strip, led_strip_rmt_obj, base);
+    ESP_RETURN_ON_FALSE(index < rmt_strip->strip_len, ESP_ERR_INVALID_ARG, TAG, "index out of maximum number of LEDs");
+
+    led_color_component_format_t component_fmt = rmt_strip->component_fmt;
+    uint32_t start = index * rmt_strip->bytes_per_pixel;
+
+    led_strip_rmt_set_byte(rmt_strip, start + component_fmt.format.r_pos, red & 0xFF);
+    led_strip_rmt_set_byte(rmt_strip, start + component_fmt.format.g_pos, green & 0xFF);
+    led_strip_rmt_set_byte(rmt_strip, start + component_fmt.format.b_pos, blue & 0xFF);
+    if (component_fmt.format.num_components > 3) {
+        led_strip_rmt_set_byte(rmt_strip, start + component_fmt.format.w_pos, 0);
+    }
+
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_rmt_set_pixel_rgbw(led_strip_t *strip, uint32_t index, uint32_t red, uint32_t green, uint32_t blue, uint32_t white)
+{
+    led_strip_rmt_obj *rmt_strip = __containerof(strip, led_strip_rmt_obj, base);
+    led_color_component_format_t component_fmt = rmt_strip->component_fmt;
+    ESP_RETURN_ON_FALSE(index < rmt_strip->strip_len, ESP_ERR_INVALID_ARG, TAG, "index out of maximum number of LEDs");
+    ESP_RETURN_ON_FALSE(component_fmt.format.num_components == 4, ESP_ERR_INVALID_ARG, TAG, "led doesn't have 4 components");
+
+    uint32_t start = index * rmt_strip->bytes_per_pixel;
+
+    led_strip_rmt_set_byte(rmt_strip, start + component_fmt.format.r_pos, red & 0xFF);
+    led_strip_rmt_set_byte(rmt_strip, start + component_fmt.format.g_pos, green & 0xFF);
+    led_strip_rmt_set_byte(rmt_strip, start + component_fmt.format.b_pos, blue & 0xFF);
+    led_strip_rmt_set_byte(rmt_strip, start + component_fmt.format.w_pos, white & 0xFF);
+
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_rmt_set_pixels(led_strip_t *strip, uint32_t start, uint32_t count, const led_strip_rgb_t *colors)
+{
+    led_strip_rmt_obj *rmt_strip = __containerof(strip, led_strip_rmt_obj, base);
+    ESP_RETURN_ON_FALSE(start <= rmt_strip->strip_len && count <= rmt_strip->strip_len - start, ESP_ERR_INVALID_ARG, TAG,
+                        "pixels out of maximum number of LEDs");
+
+    // the format is decoded once for the whole span
+    led_color_component_format_t component_fmt = rmt_strip->component_fmt;
+    uint32_t r_pos = component_fmt.format.r_pos;
+    uint32_t g_pos = component_fmt.format.g_pos;
+    uint32_t b_pos = component_fmt.format.b_pos;
+    uint32_t bytes_per_pixel = rmt_strip->bytes_per_pixel;
+    uint8_t *buf = rmt_strip->pixel_buf + start * bytes_per_pixel;
+    uint8_t changed = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        changed |= (buf[r_pos] ^ colors[i].red) | (buf[g_pos] ^ colors[i].green) | (buf[b_pos] ^ colors[i].blue);
+        buf[r_pos] = colors[i].red;
+        buf[g_pos] = colors[i].green;
+        buf[b_pos] = colors[i].blue;
+        buf += bytes_per_pixel;
+    }
+    if (component_fmt.format.num_components > 3) {
+        uint32_t w_pos = component_fmt.format.w_pos;
+        buf = rmt_strip->pixel_buf + start * bytes_per_pixel;
+        for (uint32_t i = 0; i < count; i++) {
+            changed |= buf[w_pos];
+            buf[w_pos] = 0;
+            buf += bytes_per_pixel;
+        }
+    }
+    if (changed) {
+        rmt_strip->dirty = true;
+    }
+
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_rmt_set_pixels_raw(led_strip_t *strip, uint32_t start, uint32_t count, const uint8_t *data)
+{
+    led_strip_rmt_obj *rmt_strip = __containerof(strip, led_strip_rmt_obj, base);
+    ESP_RETURN_ON_FALSE(start <= rmt_strip->strip_len && count <= rmt_strip->strip_len - start, ESP_ERR_INVALID_ARG, TAG,
+                        "pixels out of maximum number of LEDs");
+
+    uint8_t *buf = rmt_strip->pixel_buf + start * rmt_strip->bytes_per_pixel;
+    size_t size = count * rmt_strip->bytes_per_pixel;
+    if (memcmp(buf, data, size)) {
+        memcpy(buf, data, size);
+        rmt_strip->dirty = true;
+    }
+
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_rmt_refresh_wait_done(led_strip_t *strip, int32_t timeout_ms)
+{
+    led_strip_rmt_obj *rmt_strip = __containerof(strip, led_strip_rmt_obj, base);
+    if (rmt_strip->group) {
+        return led_strip_rmt_group_wait_done(rmt_strip->group, timeout_ms);
+    }
+    if (!rmt_strip->busy) {
+        return ESP_OK;
+    }
+    TickType_t timeout_ticks = timeout_ms < 0 ? portMAX_DELAY : pdMS_TO_TICKS(timeout_ms);
+    ESP_RETURN_ON_FALSE(xSemaphoreTake(rmt_strip->trans_done, timeout_ticks) == pdTRUE, ESP_ERR_TIMEOUT, TAG, "wait for refresh done timeout");
+    rmt_strip->busy = false;
+    return ESP_OK;
+}
+
+// the LEDs already show this frame, unless dithering has to move on to the next one or the frame is generated,
+// an identity pipeline leaves no fraction for dithering to spread
+static bool led_strip_rmt_frame_changed(const led_strip_rmt_obj *rmt_strip)
+{
+    return rmt_strip->dirty || (rmt_strip->pipeline.residual && !rmt_strip->pipeline.identity) || rmt_strip->generator;
+}
+
+// queue the frame on the enabled channel, its previous frame must be sent
+static esp_err_t led_strip_rmt_start(led_strip_rmt_obj *rmt_strip)
+{
+    rmt_transmit_config_t tx_conf = {
+        .loop_count = 0,
+    };
+    size_t frame_size = rmt_strip->strip_len * rmt_strip->bytes_per_pixel;
+
+    const void *payload = rmt_strip;
+    if (!rmt_strip->generator) {
+        // the pipeline writes the frame to send, the user's frame stays as it is and set_pixel keeps updating single pixels
+        led_strip_pixel_pipeline_apply(&rmt_strip->pipeline, rmt_strip->pixel_buf, rmt_strip->tx_buf);
+        payload = rmt_strip->tx_buf;
+    }
+    // a generated frame is pulled by the encoder, only its size is transmitted
+    ESP_RETURN_ON_ERROR(rmt_transmit(rmt_strip->rmt_chan, rmt_strip->strip_encoder, payload, frame_size, &tx_conf),
+                        TAG, "transmit pixels by RMT failed");
+    rmt_strip->dirty = false;
+    rmt_strip->stats.refreshes++;
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_rmt_transmit(led_strip_rmt_obj *rmt_strip)
+{
+    if (!led_strip_rmt_frame_changed(rmt_strip)) {
+        rmt_strip->stats.skipped_refreshes++;
+        return ESP_OK;
+    }
+    // only one frame on the wire, its buffer must not change until it's sent
+    ESP_RETURN_ON_ERROR(led_strip_rmt_refresh_wait_done(&rmt_strip->base, -1), TAG, "wait for previous refresh failed");
+    if (!rmt_strip->enabled) {
+        ESP_RETURN_ON_ERROR(rmt_enable(rmt_strip->rmt_chan), TAG, "enable RMT channel failed");
+        rmt_strip->enabled = true;
+    }
+    ESP_RETURN_ON_ERROR(led_strip_rmt_start(rmt_strip), TAG, "start refresh failed");
+    rmt_strip->busy = true;
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_rmt_refresh_async(led_strip_t *strip)
+{
+    led_strip_rmt_obj *rmt_strip = __containerof(strip, led_strip_rmt_obj, base);
+    if (rmt_strip->group) {
+        return led_strip_rmt_group_refresh_async(rmt_strip->group);
+    }
+    rmt_strip->keep_enabled = true;
+    return led_strip_rmt_transmit(rmt_strip);
+}
+
+static esp_err_t led_strip_rmt_refresh(led_strip_t *strip)
+{
+    led_strip_rmt_obj *rmt_strip = __containerof(strip, led_strip_rmt_obj, base);
+    if (rmt_strip->group) {
+        return led_strip_rmt_group_refresh(rmt_strip->group);
+    }
+    ESP_RETURN_ON_ERROR(led_strip_rmt_transmit(rmt_strip), TAG, "refresh failed");
+    ESP_RETURN_ON_ERROR(led_strip_rmt_refresh_wait_done(strip, -1), TAG, "wait for refresh done failed");
+    // the enabled channel holds a power management lock, only asynchronous refreshes keep it between frames
+    if (rmt_strip->enabled && !rmt_strip->keep_enabled) {
+        ESP_RETURN_ON_ERROR(rmt_disable(rmt_strip->rmt_chan), TAG, "disable RMT channel failed");
+        rmt_strip->enabled = false;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_rmt_set_pixel_pipeline(led_strip_t *strip, const led_strip_pixel_pipeline_config_t *config)
+{
+    led_strip_rmt_obj *rmt_strip = __containerof(strip, led_strip_rmt_obj, base);
+    ESP_RETURN_ON_ERROR(led_strip_pixel_pipeline_config(&rmt_strip->pipeline, config), TAG, "configure pixel pipeline failed");
+    rmt_strip->dirty = true;
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_rmt_get_stats(led_strip_t *strip, led_strip_stats_t *stats)
+{
+    led_strip_rmt_obj *rmt_strip = __containerof(strip, led_strip_rmt_obj, base);
+    *stats = rmt_strip->stats;
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_rmt_clear(led_strip_t *strip)
+{
+    led_strip_rmt_obj *rmt_strip = __containerof(strip, led_strip_rmt_obj, base);
+    // Write zero to turn off all leds
+    for (uint32_t i = 0; i < rmt_strip->strip_len * rmt_strip->bytes_per_pixel; i++) {
+        led_strip_rmt_set_byte(rmt_strip, i, 0);
+    }
+    return led_strip_rmt_refresh(strip);
+}
+
+static esp_err_t led_strip_rmt_stream_clear(led_strip_t *strip)
+{
+    led_strip_rmt_obj *rmt_strip = __containerof(strip, led_strip_rmt_obj, base);
+    // the blank frame must be sent before the generator is called again
+    ESP_RETURN_ON_ERROR(led_strip_rmt_refresh_wait_done(strip, -1), TAG, "wait for refresh done failed");
+    rmt_strip->blank = true;
+    esp_err_t ret = led_strip_rmt_refresh(strip);
+    rmt_strip->blank = false;
+    return ret;
+}
+
+static esp_err_t led_strip_rmt_del(led_strip_t *strip)
+{
+    led_strip_rmt_obj *rmt_strip = __containerof(strip, led_strip_rmt_obj, base);
+    ESP_RETURN_ON_FALSE(!rmt_strip->group, ESP_ERR_INVALID_STATE, TAG, "strip is in a group, delete the group first");
+    ESP_RETURN_ON_ERROR(led_strip_rmt_refresh_wait_done(strip, -1), TAG, "wait for refresh done failed");
+    if (rmt_strip->enabled) {
+        ESP_RETURN_ON_ERROR(rmt_disable(rmt_strip->rmt_chan), TAG, "disable RMT channel failed");
+    }
+    ESP_RETURN_ON_ERROR(rmt_del_channel(rmt_strip->rmt_chan), TAG, "delete RMT channel failed");
+    ESP_RETURN_ON_ERROR(rmt_del_encoder(rmt_strip->strip_encoder), TAG, "delete strip encoder failed");
+    vSemaphoreDelete(rmt_strip->trans_done);
+    led_strip_pixel_pipeline_deinit(&rmt_strip->pipeline);
+    free(rmt_strip);
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_rmt_new(const led_strip_config_t *led_config, const led_strip_rmt_config_t *rmt_config,
+                                   const led_strip_rmt_stream_config_t *stream_config, led_strip_handle_t *ret_strip)
+{
+    led_strip_rmt_obj *rmt_strip = NULL;
+    esp_err_t ret = ESP_OK;
+    ESP_GOTO_ON_FALSE(led_config && rmt_config && ret_strip, ESP_ERR_INVALID_ARG, err, TAG, "invalid argument");
+    ESP_GOTO_ON_FALSE(!stream_config || stream_config->generator, ESP_ERR_INVALID_ARG, err, TAG, "invalid generator");
+    led_color_component_format_t component_fmt = led_config->color_component_format;
+    // If R/G/B order is not specified, set default GRB order as fallback
+    if (component_fmt.format_id == 0) {
+        component_fmt = LED_STRIP_COLOR_COMPONENT_FMT_GRB;
+    }
+    // check the validation of the color component format
+    uint8_t mask = 0;
+    if (component_fmt.format.num_components == 3) {
+        mask = BIT(component_fmt.format.r_pos) | BIT(component_fmt.format.g_pos) | BIT(component_fmt.format.b_pos);
+        // Check for invalid values
+        ESP_RETURN_ON_FALSE(mask == 0x07, ESP_ERR_INVALID_ARG, TAG, "invalid order argument");
+    } else if (component_fmt.format.num_components == 4) {
+        mask = BIT(component_fmt.format.r_pos) | BIT(component_fmt.format.g_pos) | BIT(component_fmt.format.b_pos) | BIT(component_fmt.format.w_pos);
+        // Check for invalid values
+        ESP_RETURN_ON_FALSE(mask == 0x0F, ESP_ERR_INVALID_ARG, TAG, "invalid order argument");
+    } else {
+        ESP_RETURN_ON_FALSE(false, ESP_ERR_INVALID_ARG, TAG, "invalid number of color components: %d", component_fmt.format.num_components);
+    }
+    // TODO: we assume each color component is 8 bits, may need to support other configurations in the future, e.g. 10bits per color component?
+    uint8_t bytes_per_pixel = component_fmt.format.num_components;
+    // two frames, one drawn while the other one is sent, none if the frames are generated
+    size_t frame_size = stream_config ? 0 : led_config->max_leds * bytes_per_pixel;
+    rmt_strip = calloc(1, sizeof(led_strip_rmt_obj) + 2 * frame_size);
+    ESP_GOTO_ON_FALSE(rmt_strip, ESP_ERR_NO_MEM, err, TAG, "no mem for rmt strip");
+    if (!stream_config) {
+        rmt_strip->pixel_buf = rmt_strip->pixel_mem;
+        rmt_strip->tx_buf = rmt_strip->pixel_mem + frame_size;
+    }
+    led_strip_pixel_pipeline_init(&rmt_strip->pipeline, frame_size);
+    // whatever the LEDs show at power on, the first refresh has to send the frame
+    rmt_strip->dirty = true;
+    rmt_strip->trans_done = xSemaphoreCreateBinary();
+    ESP_GOTO_ON_FALSE(rmt_strip->trans_done, ESP_ERR_NO_MEM, err, TAG, "no mem for trans done semaphore");
+    uint32_t resolution = rmt_config->resolution_hz ? rmt_config->resolution_hz : LED_STRIP_RMT_DEFAULT_RESOLUTION;
+
+    // for backward compatibility, if the user does not set the clk_src, use the default value
+    rmt_clock_source_t clk_src = RMT_CLK_SRC_DEFAULT;
+    if (rmt_config->clk_src) {
+        clk_src = rmt_config->clk_src;
+    }
+    size_t mem_block_symbols = LED_STRIP_RMT_DEFAULT_MEM_BLOCK_SYMBOLS;
+    // override the default value if the user sets it
+    if (rmt_config->mem_block_symbols) {
+        mem_block_symbols = rmt_config->mem_block_symbols;
+    }
+    rmt_tx_channel_config_t rmt_chan_config = {
+        .clk_src = clk_src,
+        .gpio_num = led_config->strip_gpio_num,
+        .mem_block_symbols = mem_block_symbols,
+        .resolution_hz = resolution,
+        .trans_queue_depth = LED_STRIP_RMT_DEFAULT_TRANS_QUEUE_SIZE,
+        .flags.with_dma = rmt_config->flags.with_dma,
+        .flags.invert_out = led_config->flags.invert_out,
+    };
+    ESP_GOTO_ON_ERROR(rmt_new_tx_channel(&rmt_chan_config, &rmt_strip->rmt_chan), err, TAG, "create RMT TX channel failed");
+    rmt_tx_event_callbacks_t cbs = {
+        .on_trans_done = led_strip_rmt_on_trans_done,
+    };
+    ESP_GOTO_ON_ERROR(rmt_tx_register_event_callbacks(rmt_strip->rmt_chan, &cbs, rmt_strip), err, TAG, "register RMT callbacks failed");
+
+    led_strip_encoder_config_t strip_encoder_conf = {
+        .resolution = resolution,
+        .led_model = led_config->led_model
+    };
+    if (stream_config) {
+        uint32_t chunk_pixels = stream_config->chunk_pixels ? stream_config->chunk_pixels : LED_STRIP_RMT_DEFAULT_STREAM_CHUNK_PIXELS;
+        rmt_strip->generator = stream_config->generator;
+        rmt_strip->generator_ctx = stream_config->user_ctx;
+        strip_encoder_conf.generator = led_strip_rmt_stream_generate;
+        strip_encoder_conf.generator_ctx = rmt_strip;
+        strip_encoder_conf.chunk_size = chunk_pixels * bytes_per_pixel;
+    }
+    ESP_GOTO_ON_ERROR(rmt_new_led_strip_encoder(&strip_encoder_conf, &rmt_strip->strip_encoder), err, TAG, "create LED strip encoder failed");
+
+    rmt_strip->component_fmt = component_fmt;
+    rmt_strip->bytes_per_pixel = bytes_per_pixel;
+    rmt_strip->strip_len = led_config->max_leds;
+    // there are no pixels to set on a streamed strip
+    if (!stream_config) {
+        rmt_strip->base.set_pixel = led_strip_rmt_set_pixel;
+        rmt_strip->base.set_pixel_rgbw = led_strip_rmt_set_pixel_rgbw;
+        rmt_strip->base.set_pixels = led_strip_rmt_set_pixels;
+        rmt_strip->base.set_pixels_raw = led_strip_rmt_set_pixels_raw;
+        rmt_strip->base.set_pixel_pipeline = led_strip_rmt_set_pixel_pipeline;
+        rmt_strip->base.clear = led_strip_rmt_clear;
+    } else {
+        rmt_strip->base.clear = led_strip_rmt_stream_clear;
+    }
+    rmt_strip->base.refresh = led_strip_rmt_refresh;
+    rmt_strip->base.refresh_async = led_strip_rmt_refresh_async;
+    rmt_strip->base.refresh_wait_done = led_strip_rmt_refresh_wait_done;
+    rmt_strip->base.get_stats = led_strip_rmt_get_stats;
+    rmt_strip->base.del = led_strip_rmt_del;
+
+    *ret_strip = &rmt_strip->base;
+    return ESP_OK;
+err:
+    if (rmt_strip) {
+        if (rmt_strip->rmt_chan) {
+            rmt_del_channel(rmt_strip->rmt_chan);
+        }
+        if (rmt_strip->strip_encoder) {
+            rmt_del_encoder(rmt_strip->strip_encoder);
+        }
+        if (rmt_strip->trans_done) {
+            vSemaphoreDelete(rmt_strip->trans_done);
+        }
+        led_strip_pixel_pipeline_deinit(&rmt_strip->pipeline);
+        free(rmt_strip);
+    }
+    return ret;
+}
+
+esp_err_t led_strip_new_rmt_device(const led_strip_config_t *led_config, const led_strip_rmt_config_t *rmt_config, led_strip_handle_t *ret_strip)
+{
+    return led_strip_rmt_new(led_config, rmt_config, NULL, ret_strip);
+}
+
+esp_err_t led_strip_new_rmt_stream_device(const led_strip_config_t *led_config, const led_strip_rmt_config_t *rmt_config,
+                                          const led_strip_rmt_stream_config_t *stream_config, led_strip_handle_t *ret_strip)
+{
+    ESP_RETURN_ON_FALSE(stream_config, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    return led_strip_rmt_new(led_config, rmt_config, stream_config, ret_strip);
+}
+
+esp_err_t led_strip_rmt_new_group(const led_strip_handle_t *strips, size_t nr_strips, led_strip_rmt_group_handle_t *ret_group)
+{
+    esp_err_t ret = ESP_OK;
+    led_strip_rmt_group_handle_t group = NULL;
+    rmt_channel_handle_t channels[SOC_RMT_TX_CANDIDATES_PER_GROUP];
+    bool was_enabled[SOC_RMT_TX_CANDIDATES_PER_GROUP];
+    bool was_kept_enabled[SOC_RMT_TX_CANDIDATES_PER_GROUP];
+    size_t nr_prepared = 0;
+    ESP_RETURN_ON_FALSE(strips && nr_strips && ret_group, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(nr_strips <= SOC_RMT_TX_CANDIDATES_PER_GROUP, ESP_ERR_INVALID_ARG, TAG, "more strips than RMT TX channels");
+    for (size_t i = 0; i < nr_strips; i++) {
+        ESP_RETURN_ON_FALSE(strips[i] && strips[i]->del == led_strip_rmt_del, ESP_ERR_INVALID_ARG, TAG, "strip %zu is not an RMT strip", i);
+        ESP_RETURN_ON_FALSE(!__containerof(strips[i], led_strip_rmt_obj, base)->group, ESP_ERR_INVALID_STATE, TAG, "strip %zu is already in a group", i);
+        for (size_t j = 0; j < i; j++) {
+            ESP_RETURN_ON_FALSE(strips[j] != strips[i], ESP_ERR_INVALID_ARG, TAG, "strip %zu is given twice", i);
+        }
+    }
+    group = calloc(1, sizeof(struct led_strip_rmt_group_t) + nr_strips * sizeof(led_strip_rmt_obj *));
+    ESP_RETURN_ON_FALSE(group, ESP_ERR_NO_MEM, TAG, "no mem for strip group");
+    group->trans_done = xSemaphoreCreateBinary();
+    ESP_GOTO_ON_FALSE(group->trans_done, ESP_ERR_NO_MEM, err, TAG, "no mem for trans done semaphore");
+    for (size_t i = 0; i < nr_strips; i++) {
+        led_strip_rmt_obj *rmt_strip = __containerof(strips[i], led_strip_rmt_obj, base);
+        // the sync manager only takes enabled channels, they stay enabled even after the group is deleted
+        ESP_GOTO_ON_ERROR(led_strip_rmt_refresh_wait_done(&rmt_strip->base, -1), err, TAG, "wait for refresh done failed");
+        was_enabled[i] = rmt_strip->enabled;
+        was_kept_enabled[i] = rmt_strip->keep_enabled;
+        if (!rmt_strip->enabled) {
+            ESP_GOTO_ON_ERROR(rmt_enable(rmt_strip->rmt_chan), err, TAG, "enable RMT channel failed");
+            rmt_strip->enabled = true;
+        }
+        rmt_strip->keep_enabled = true;
+        nr_prepared++;
+        group->strips[i] = rmt_strip;
+        channels[i] = rmt_strip->rmt_chan;
+    }
+    group->nr_strips = nr_strips;
+    rmt_sync_manager_config_t sync_config = {
+        .tx_channel_array = channels,
+        .array_size = nr_strips,
+    };
+    ESP_GOTO_ON_ERROR(rmt_new_sync_manager(&sync_config, &group->sync_manager), err, TAG, "create sync manager failed");
+    for (size_t i = 0; i < nr_strips; i++) {
+        group->strips[i]->group = group;
+    }
+
+    *ret_group = group;
+    return ESP_OK;
+err:
+    // the strips go back to how they were, a failed group leaves no channel enabled behind
+    for (size_t i = 0; i < nr_prepared; i++) {
+        led_strip_rmt_obj *rmt_strip = group->strips[i];
+        if (!was_enabled[i]) {
+            rmt_disable(rmt_strip->rmt_chan);
+            rmt_strip->enabled = false;
+        }
+        rmt_strip->keep_enabled = was_kept_enabled[i];
+    }
+    if (group->trans_done) {
+        vSemaphoreDelete(group->trans_done);
+    }
+    free(group);
+    return ret;
+}
+
+esp_err_t led_strip_rmt_group_refresh_async(led_strip_rmt_group_handle_t group)
+{
+    esp_err_t ret = ESP_OK;
+    size_t nr_started = 0;
+    ESP_RETURN_ON_FALSE(group, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    bool changed = false;
+    for (size_t i = 0; i < group->nr_strips; i++) {
+        changed |= led_strip_rmt_frame_changed(group->strips[i]);
+    }
+    // the sync manager starts the channels once each of them has a frame, every strip is sent or none
+    if (!changed) {
+        for (size_t i = 0; i < group->nr_strips; i++) {
+            group->strips[i]->stats.skipped_refreshes++;
+        }
+        return ESP_OK;
+    }
+    ESP_RETURN_ON_ERROR(led_strip_rmt_group_wait_done(group, -1), TAG, "wait for previous refresh failed");
+    if (group->started) {
+        ESP_RETURN_ON_ERROR(rmt_sync_reset(group->sync_manager), TAG, "reset sync manager failed");
+    }
+    atomic_store(&group->pending, group->nr_strips);
+    for (; nr_started < group->nr_strips; nr_started++) {
+        ESP_GOTO_ON_ERROR(led_strip_rmt_start(group->strips[nr_started]), err, TAG, "start refresh failed");
+    }
+    group->started = true;
+    group->busy = true;
+    return ESP_OK;
+err:
+    // the sync manager holds the frames queued so far until every channel has one, drop them and start over
+    for (size_t i = 0; i < nr_started; i++) {
+        led_strip_rmt_obj *rmt_strip = group->strips[i];
+        rmt_disable(rmt_strip->rmt_chan);
+        rmt_enable(rmt_strip->rmt_chan);
+        rmt_strip->dirty = true;
+        rmt_strip->stats.refreshes--;
+    }
+    atomic_store(&group->pending, 0);
+    rmt_sync_reset(group->sync_manager);
+    group->started = false;
+    return ret;
+}
+
+esp_err_t led_strip_rmt_group_wait_done(led_strip_rmt_group_handle_t group, int32_t timeout_ms)
+{
+    ESP_RETURN_ON_FALSE(group, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    if (!group->busy) {
+        return ESP_OK;
+    }
+    TickType_t timeout_ticks = timeout_ms < 0 ? portMAX_DELAY : pdMS_TO_TICKS(timeout_ms);
+    ESP_RETURN_ON_FALSE(xSemaphoreTake(group->trans_done, timeout_ticks) == pdTRUE, ESP_ERR_TIMEOUT, TAG, "wait for refresh done timeout");
+    group->busy = false;
+    return ESP_OK;
+}
+
+esp_err_t led_strip_rmt_group_refresh(led_strip_rmt_group_handle_t group)
+{
+    ESP_RETURN_ON_ERROR(led_strip_rmt_group_refresh_async(group), TAG, "refresh failed");
+    return led_strip_rmt_group_wait_done(group, -1);
+}
+
+esp_err_t led_strip_rmt_del_group(led_strip_rmt_group_handle_t group)
+{
+    ESP_RETURN_ON_FALSE(group, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_ERROR(led_strip_rmt_group_wait_done(group, -1), TAG, "wait for refresh done failed");
+    ESP_RETURN_ON_ERROR(rmt_del_sync_manager(group->sync_manager), TAG, "delete sync manager failed");
+    for (size_t i = 0; i < group->nr_strips; i++) {
+        group->strips[i]->group = NULL;
+    }
+    vSemaphoreDelete(group->trans_done);
+    free(group);
+    return ESP_OK;
+}
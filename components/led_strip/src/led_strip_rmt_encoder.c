@@ -0,0 +1,231 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "esp_check.h"
+#include "esp_idf_version.h"
+#include "led_strip_rmt_encoder.h"
+#include "led_strip_rmt_lut.h"
+
+// the simple encoder lets the callback write symbols itself, one table lookup per byte instead of one branch per bit
+#define LED_STRIP_RMT_LUT_ENCODER (ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 3, 0))
+
+static const char *TAG = "led_rmt_encoder";
+
+typedef struct {
+    rmt_encoder_t base;
+    rmt_encoder_t *bytes_encoder; // encodes the pixels, from the symbol table when there is one
+    rmt_encoder_t *copy_encoder;
+    int state;
+    rmt_symbol_word_t reset_code;
+    led_strip_encoder_generator_t generator; // pulls the frame in chunks, NULL to encode the transmitted data
+    void *generator_ctx;
+    size_t offset;                           // bytes of the frame pulled from the generator
+    size_t chunk_len;                        // bytes in `chunk` still to encode
+    size_t chunk_size;
+    uint8_t chunk[];
+} rmt_led_strip_encoder_t;
+
+static size_t rmt_encode_led_strip_stream(rmt_led_strip_encoder_t *led_encoder, rmt_channel_handle_t channel, size_t data_size, rmt_encode_state_t *ret_state)
+{
+    rmt_encoder_handle_t bytes_encoder = led_encoder->bytes_encoder;
+    rmt_encode_state_t session_state = 0;
+    size_t encoded_symbols = 0;
+    while (true) {
+        if (!led_encoder->chunk_len) {
+            if (led_encoder->offset == data_size) {
+                led_encoder->offset = 0; // the next frame is pulled from its start
+                *ret_state = RMT_ENCODING_COMPLETE;
+                return encoded_symbols;
+            }
+            size_t size = data_size - led_encoder->offset;
+            if (size > led_encoder->chunk_size) {
+                size = led_encoder->chunk_size;
+            }
+            led_encoder->generator(led_encoder->offset, led_encoder->chunk, size, led_encoder->generator_ctx);
+            led_encoder->offset += size;
+            led_encoder->chunk_len = size;
+        }
+        // the bytes encoder keeps its position in the chunk until it's complete, then starts over with the next one
+        encoded_symbols += bytes_encoder->encode(bytes_encoder, channel, led_encoder->chunk, led_encoder->chunk_len, &session_state);
+        if (session_state & RMT_ENCODING_COMPLETE) {
+            led_encoder->chunk_len = 0;
+        }
+        if (session_state & RMT_ENCODING_MEM_FULL) {
+            *ret_state = RMT_ENCODING_MEM_FULL;
+            return encoded_symbols; // the rest of the frame is pulled once the RMT memory is refilled
+        }
+    }
+}
+
+static size_t rmt_encode_led_strip(rmt_encoder_t *encoder, rmt_channel_handle_t channel, const void *primary_data, size_t data_size, rmt_encode_state_t *ret_state)
+{
+    rmt_led_strip_encoder_t *led_encoder = __containerof(encoder, rmt_led_strip_encoder_t, base);
+    rmt_encoder_handle_t bytes_encoder = led_encoder->bytes_encoder;
+    rmt_encoder_handle_t copy_encoder = led_encoder->copy_encoder;
+    rmt_encode_state_t session_state = 0;
+    rmt_encode_state_t state = 0;
+    size_t encoded_symbols = 0;
+    switch (led_encoder->state) {
+    case 0: // send RGB data
+        if (led_encoder->generator) {
+            encoded_symbols += rmt_encode_led_strip_stream(led_encoder, channel, data_size, &session_state);
+        } else {
+            encoded_symbols += bytes_encoder->encode(bytes_encoder, channel, primary_data, data_size, &session_state);
+        }
+        if (session_state & RMT_ENCODING_COMPLETE) {
+            led_encoder->state = 1; // switch to next state when current encoding session finished
+        }
+        if (session_state & RMT_ENCODING_MEM_FULL) {
+            state |= RMT_ENCODING_MEM_FULL;
+            goto out; // yield if there's no free space for encoding artifacts
+        }
+    // fall-through
+    case 1: // send reset code
+        encoded_symbols += copy_encoder->encode(copy_encoder, channel, &led_encoder->reset_code,
+                                                sizeof(led_encoder->reset_code), &session_state);
+        if (session_state & RMT_ENCODING_COMPLETE) {
+            led_encoder->state = 0; // back to the initial encoding session
+            state |= RMT_ENCODING_COMPLETE;
+        }
+        if (session_state & RMT_ENCODING_MEM_FULL) {
+            state |= RMT_ENCODING_MEM_FULL;
+            goto out; // yield if there's no free space for encoding artifacts
+        }
+    }
+out:
+    *ret_state = state;
+    return encoded_symbols;
+}
+
+#if LED_STRIP_RMT_LUT_ENCODER
+static size_t rmt_encode_led_strip_lut(const void *data, size_t data_size, size_t symbols_written, size_t symbols_free,
+                                       rmt_symbol_word_t *symbols, bool *done, void *arg)
+{
+    const led_strip_rmt_lut_t *lut = (const led_strip_rmt_lut_t *)arg;
+    size_t offset = symbols_written / 8;
+    size_t size = data_size - offset;
+    if (size > symbols_free / 8) {
+        size = symbols_free / 8;
+    }
+    led_strip_rmt_lut_encode(lut, (const uint8_t *)data + offset, size, symbols);
+    *done = offset + size == data_size;
+    return size * 8;
+}
+#endif
+
+static esp_err_t rmt_del_led_strip_encoder(rmt_encoder_t *encoder)
+{
+    rmt_led_strip_encoder_t *led_encoder = __containerof(encoder, rmt_led_strip_encoder_t, base);
+    rmt_del_encoder(led_encoder->bytes_encoder);
+    rmt_del_encoder(led_encoder->copy_encoder);
+    free(led_encoder);
+    return ESP_OK;
+}
+
+static esp_err_t rmt_led_strip_encoder_reset(rmt_encoder_t *encoder)
+{
+    rmt_led_strip_encoder_t *led_encoder = __containerof(encoder, rmt_led_strip_encoder_t, base);
+    rmt_encoder_reset(led_encoder->bytes_encoder);
+    rmt_encoder_reset(led_encoder->copy_encoder);
+    led_encoder->state = 0;
+    led_encoder->offset = 0;
+    led_encoder->chunk_len = 0;
+    return ESP_OK;
+}
+
+esp_err_t rmt_new_led_strip_encoder(const led_strip_encoder_config_t *config, rmt_encoder_handle_t *ret_encoder)
+{
+    esp_err_t ret = ESP_OK;
+    rmt_led_strip_encoder_t *led_encoder = NULL;
+    ESP_GOTO_ON_FALSE(config && ret_encoder, ESP_ERR_INVALID_ARG, err, TAG, "invalid argument");
+    ESP_GOTO_ON_FALSE(config->led_model < LED_MODEL_INVALID, ESP_ERR_INVALID_ARG, err, TAG, "invalid led model");
+    ESP_GOTO_ON_FALSE(!config->generator || config->chunk_size, ESP_ERR_INVALID_ARG, err, TAG, "invalid chunk size");
+    // a generated frame only takes one chunk of memory
+    size_t chunk_size = config->generator ? config->chunk_size : 0;
+    led_encoder = calloc(1, sizeof(rmt_led_strip_encoder_t) + chunk_size);
+    ESP_GOTO_ON_FALSE(led_encoder, ESP_ERR_NO_MEM, err, TAG, "no mem for led strip encoder");
+    led_encoder->generator = config->generator;
+    led_encoder->generator_ctx = config->generator_ctx;
+    led_encoder->chunk_size = chunk_size;
+    led_encoder->base.encode = rmt_encode_led_strip;
+    led_encoder->base.del = rmt_del_led_strip_encoder;
+    led_encoder->base.reset = rmt_led_strip_encoder_reset;
+#if LED_STRIP_RMT_LUT_ENCODER
+    const led_strip_rmt_lut_t *lut = led_strip_rmt_lut_get(config->led_model, config->resolution);
+    if (lut) {
+        rmt_simple_encoder_config_t simple_encoder_config = {
+            .callback = rmt_encode_led_strip_lut,
+            .arg = (void *)lut,
+            .min_chunk_size = 8, // one byte
+        };
+        ESP_GOTO_ON_ERROR(rmt_new_simple_encoder(&simple_encoder_config, &led_encoder->bytes_encoder), err, TAG, "create simple encoder failed");
+    }
+#endif
+    if (!led_encoder->bytes_encoder) {
+        // no table for this resolution, encode bit by bit
+        rmt_bytes_encoder_config_t bytes_encoder_config;
+        if (config->led_model == LED_MODEL_SK6812) {
+            bytes_encoder_config = (rmt_bytes_encoder_config_t) {
+                .bit0 = {
+                    .level0 = 1,
+                    .duration0 = LED_STRIP_RMT_TICKS(config->resolution, LED_STRIP_SK6812_T0H_NS),
+                    .level1 = 0,
+                    .duration1 = LED_STRIP_RMT_TICKS(config->resolution, LED_STRIP_SK6812_T0L_NS),
+                },
+                .bit1 = {
+                    .level0 = 1,
+                    .duration0 = LED_STRIP_RMT_TICKS(config->resolution, LED_STRIP_SK6812_T1H_NS),
+                    .level1 = 0,
+                    .duration1 = LED_STRIP_RMT_TICKS(config->resolution, LED_STRIP_SK6812_T1L_NS),
+                },
+                .flags.msb_first = 1 // SK6812 transfer bit order: G7...G0R7...R0B7...B0(W7...W0)
+            };
+        } else if (config->led_model == LED_MODEL_WS2812) {
+            // different led strip might have its own timing requirements, following parameter is for WS2812
+            bytes_encoder_config = (rmt_bytes_encoder_config_t) {
+                .bit0 = {
+                    .level0 = 1,
+                    .duration0 = LED_STRIP_RMT_TICKS(config->resolution, LED_STRIP_WS2812_T0H_NS),
+                    .level1 = 0,
+                    .duration1 = LED_STRIP_RMT_TICKS(config->resolution, LED_STRIP_WS2812_T0L_NS),
+                },
+                .bit1 = {
+                    .level0 = 1,
+                    .duration0 = LED_STRIP_RMT_TICKS(config->resolution, LED_STRIP_WS2812_T1H_NS),
+                    .level1 = 0,
+                    .duration1 = LED_STRIP_RMT_TICKS(config->resolution, LED_STRIP_WS2812_T1L_NS),
+                },
+                .flags.msb_first = 1 // WS2812 transfer bit order: G7...G0R7...R0B7...B0
+            };
+        } else {
+            assert(false);
+        }
+        ESP_GOTO_ON_ERROR(rmt_new_bytes_encoder(&bytes_encoder_config, &led_encoder->bytes_encoder), err, TAG, "create bytes encoder failed");
+    }
+    rmt_copy_encoder_config_t copy_encoder_config = {};
+    ESP_GOTO_ON_ERROR(rmt_new_copy_encoder(&copy_encoder_config, &led_encoder->copy_encoder), err, TAG, "create copy encoder failed");
+
+    uint32_t reset_ticks = config->resolution / 1000000 * 280 / 2; // reset code duration defaults to 280us to accomodate WS2812B-V5
+    led_encoder->reset_code = (rmt_symbol_word_t) {
+        .level0 = 0,
+        .duration0 = reset_ticks,
+        .level1 = 0,
+        .duration1 = reset_ticks,
+    };
+    *ret_encoder = &led_encoder->base;
+    return ESP_OK;
+err:
+    if (led_encoder) {
+        if (led_encoder->bytes_encoder) {
+            rmt_del_encoder(led_encoder->bytes_encoder);
+        }
+        if (led_encoder->copy_encoder) {
+            rmt_del_encoder(led_encoder->copy_encoder);
+        }
+        free(led_encoder);
+    }
+    return ret;
+}
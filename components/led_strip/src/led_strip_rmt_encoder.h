@@ -13,12 +13,21 @@
 extern "C" {
 #endif
 
+/**
+ * @brief Fill `size` bytes of the frame, starting at byte `offset`, called from the RMT ISR
+ */
+typedef void (*led_strip_encoder_generator_t)(size_t offset, uint8_t *buf, size_t size, void *user_ctx);
+
 /**
  * @brief Type of led strip encoder configuration
  */
 typedef struct {
     uint32_t resolution;   /*!< Encoder resolution, in Hz */
     led_model_t led_model; /*!< LED model */
+    led_strip_encoder_generator_t generator; /*!< Pulls the frame in chunks as the RMT memory is refilled, the transmitted data is
+                                                  then ignored and only its size is used. NULL to encode the transmitted data */
+    void *generator_ctx;   /*!< User context passed to the generator */
+    size_t chunk_size;     /*!< Bytes pulled from the generator at once */
 } led_strip_encoder_config_t;
 
 /**
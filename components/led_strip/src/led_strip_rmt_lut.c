@@ -0,0 +1,61 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "led_strip_rmt_lut.h"
+
+#define LUT_TICKS(ns) LED_STRIP_RMT_TICKS(LED_STRIP_RMT_LUT_RESOLUTION, ns)
+// high level first, then low level
+#define LUT_SYMBOL(high_ns, low_ns) ((1u << 15) | LUT_TICKS(high_ns) | (LUT_TICKS(low_ns) << 16))
+
+#define WS2812_BIT0 LUT_SYMBOL(LED_STRIP_WS2812_T0H_NS, LED_STRIP_WS2812_T0L_NS)
+#define WS2812_BIT1 LUT_SYMBOL(LED_STRIP_WS2812_T1H_NS, LED_STRIP_WS2812_T1L_NS)
+#define SK6812_BIT0 LUT_SYMBOL(LED_STRIP_SK6812_T0H_NS, LED_STRIP_SK6812_T0L_NS)
+#define SK6812_BIT1 LUT_SYMBOL(LED_STRIP_SK6812_T1H_NS, LED_STRIP_SK6812_T1L_NS)
+
+// both models send the most significant bit first
+#define LUT_BIT(model, byte, bit) { .val = (((byte) >> (7 - (bit))) & 1) ? model##_BIT1 : model##_BIT0 }
+#define LUT_BYTE(model, byte) { \
+    LUT_BIT(model, byte, 0), LUT_BIT(model, byte, 1), LUT_BIT(model, byte, 2), LUT_BIT(model, byte, 3), \
+    LUT_BIT(model, byte, 4), LUT_BIT(model, byte, 5), LUT_BIT(model, byte, 6), LUT_BIT(model, byte, 7) }
+#define LUT_16(model, byte) \
+    LUT_BYTE(model, (byte) + 0), LUT_BYTE(model, (byte) + 1), LUT_BYTE(model, (byte) + 2), LUT_BYTE(model, (byte) + 3), \
+    LUT_BYTE(model, (byte) + 4), LUT_BYTE(model, (byte) + 5), LUT_BYTE(model, (byte) + 6), LUT_BYTE(model, (byte) + 7), \
+    LUT_BYTE(model, (byte) + 8), LUT_BYTE(model, (byte) + 9), LUT_BYTE(model, (byte) + 10), LUT_BYTE(model, (byte) + 11), \
+    LUT_BYTE(model, (byte) + 12), LUT_BYTE(model, (byte) + 13), LUT_BYTE(model, (byte) + 14), LUT_BYTE(model, (byte) + 15)
+#define LUT_256(model) { \
+    LUT_16(model, 0x00), LUT_16(model, 0x10), LUT_16(model, 0x20), LUT_16(model, 0x30), \
+    LUT_16(model, 0x40), LUT_16(model, 0x50), LUT_16(model, 0x60), LUT_16(model, 0x70), \
+    LUT_16(model, 0x80), LUT_16(model, 0x90), LUT_16(model, 0xA0), LUT_16(model, 0xB0), \
+    LUT_16(model, 0xC0), LUT_16(model, 0xD0), LUT_16(model, 0xE0), LUT_16(model, 0xF0) }
+
+static const led_strip_rmt_lut_t s_ws2812_lut = LUT_256(WS2812);
+static const led_strip_rmt_lut_t s_sk6812_lut = LUT_256(SK6812);
+
+const led_strip_rmt_lut_t *led_strip_rmt_lut_get(led_model_t led_model, uint32_t resolution)
+{
+    if (resolution != LED_STRIP_RMT_LUT_RESOLUTION) {
+        return NULL;
+    }
+    switch (led_model) {
+    case LED_MODEL_WS2812:
+        return &s_ws2812_lut;
+    case LED_MODEL_SK6812:
+        return &s_sk6812_lut;
+    default:
+        return NULL;
+    }
+}
+
+void led_strip_rmt_lut_encode(const led_strip_rmt_lut_t *lut, const uint8_t *data, size_t size, rmt_symbol_word_t *symbols)
+{
+    for (size_t i = 0; i < size; i++) {
+        const rmt_symbol_word_t *byte_symbols = (*lut)[data[i]];
+        // word by word, the symbols may go straight to the RMT channel memory
+        for (int bit = 0; bit < 8; bit++) {
+            symbols[bit].val = byte_symbols[bit].val;
+        }
+        symbols += 8;
+    }
+}
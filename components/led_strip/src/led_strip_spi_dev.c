@@ -12,11 +12,12 @@
 #include "soc/spi_periph.h"
 #include "led_strip.h"
 #include "led_strip_interface.h"
+#include "led_strip_spi_lut.h"
 
 #define LED_STRIP_SPI_DEFAULT_RESOLUTION (2.5 * 1000 * 1000) // 2.5MHz resolution
 #define LED_STRIP_SPI_DEFAULT_TRANS_QUEUE_SIZE 4
 
-#define SPI_BYTES_PER_COLOR_BYTE 3
+#define SPI_BYTES_PER_COLOR_BYTE LED_STRIP_SPI_BYTES_PER_COLOR_BYTE
 #define SPI_BITS_PER_COLOR_BYTE (SPI_BYTES_PER_COLOR_BYTE * 8)
 
 static const char *TAG = "led_strip_spi";
@@ -25,26 +26,31 @@ typedef struct {
     led_strip_t base;
     spi_host_device_t spi_host;
     spi_device_handle_t spi_device;
+    bool dirty; // `pixel_buf` changed since the last frame sent
+    led_strip_stats_t stats;
     uint32_t strip_len;
     uint8_t bytes_per_pixel;
     led_color_component_format_t component_fmt;
     uint8_t pixel_buf[];
 } led_strip_spi_obj;
 
-// please make sure to zero-initialize the buf before calling this function
-static void __led_strip_spi_bit(uint8_t data, uint8_t *buf)
+// Store the SPI pattern of a color byte, returns non-zero if it changed
+static inline uint8_t led_strip_spi_store(uint8_t *buf, uint8_t value)
 {
-    // Each color of 1 bit is represented by 3 bits of SPI, low_level:100 ,high_level:110
-    // So a color byte occupies 3 bytes of SPI.
-    *(buf + 2) |= data & BIT(0) ? BIT(2) | BIT(1) : BIT(2);
-    *(buf + 2) |= data & BIT(1) ? BIT(5) | BIT(4) : BIT(5);
-    *(buf + 2) |= data & BIT(2) ? BIT(7) : 0x00;
-    *(buf + 1) |= BIT(0);
-    *(buf + 1) |= data & BIT(3) ? BIT(3) | BIT(2) : BIT(3);
-    *(buf + 1) |= data & BIT(4) ? BIT(6) | BIT(5) : BIT(6);
-    *(buf + 0) |= data & BIT(5) ? BIT(1) | BIT(0) : BIT(1);
-    *(buf + 0) |= data & BIT(6) ? BIT(4) | BIT(3) : BIT(4);
-    *(buf + 0) |= data & BIT(7) ? BIT(7) | BIT(6) : BIT(7);
+    const uint8_t *pattern = led_strip_spi_lut[value];
+    uint8_t changed = (buf[0] ^ pattern[0]) | (buf[1] ^ pattern[1]) | (buf[2] ^ pattern[2]);
+    buf[0] = pattern[0];
+    buf[1] = pattern[1];
+    buf[2] = pattern[2];
+    return changed;
+}
+
+// `offset` counts color bytes, each is stored as its 3 byte SPI pattern
+static void led_strip_spi_set_byte(led_strip_spi_obj *spi_strip, uint32_t offset, uint8_t value)
+{
+    if (led_strip_spi_store(&spi_strip->pixel_buf[offset * SPI_BYTES_PER_COLOR_BYTE], value)) {
+        spi_strip->dirty = true;
+    }
 }
 
 static esp_err_t led_strip_spi_set_pixel(led_strip_t *strip, uint32_t index, uint32_t red, uint32_t green, uint32_t blue)
@@ -52,16 +58,14 @@ static esp_err_t led_strip_spi_set_pixel(led_strip_t *strip, uint32_t index, uin
     led_strip_spi_obj *spi_strip = __containerof(strip, led_strip_spi_obj, base);
     ESP_RETURN_ON_FALSE(index < spi_strip->strip_len, ESP_ERR_INVALID_ARG, TAG, "index out of maximum number of LEDs");
     // 3 pixels take 72bits(9bytes)
-    uint32_t start = index * spi_strip->bytes_per_pixel * SPI_BYTES_PER_COLOR_BYTE;
-    uint8_t *pixel_buf = spi_strip->pixel_buf;
+    uint32_t start = index * spi_strip->bytes_per_pixel;
     led_color_component_format_t component_fmt = spi_strip->component_fmt;
-    memset(pixel_buf + start, 0, spi_strip->bytes_per_pixel * SPI_BYTES_PER_COLOR_BYTE);
 
-    __led_strip_spi_bit(red, &pixel_buf[start + SPI_BYTES_PER_COLOR_BYTE * component_fmt.format.r_pos]);
-    __led_strip_spi_bit(green, &pixel_buf[start + SPI_BYTES_PER_COLOR_BYTE * component_fmt.format.g_pos]);
-    __led_strip_spi_bit(blue, &pixel_buf[start + SPI_BYTES_PER_COLOR_BYTE * component_fmt.format.b_pos]);
+    led_strip_spi_set_byte(spi_strip, start + component_fmt.format.r_pos, red & 0xFF);
+    led_strip_spi_set_byte(spi_strip, start + component_fmt.format.g_pos, green & 0xFF);
+    led_strip_spi_set_byte(spi_strip, start + component_fmt.format.b_pos, blue & 0xFF);
     if (component_fmt.format.num_components > 3) {
-        __led_strip_spi_bit(0, &pixel_buf[start + SPI_BYTES_PER_COLOR_BYTE * component_fmt.format.w_pos]);
+        led_strip_spi_set_byte(spi_strip, start + component_fmt.format.w_pos, 0);
     }
 
     return ESP_OK;
@@ -75,14 +79,67 @@ static esp_err_t led_strip_spi_set_pixel_rgbw(led_strip_t *strip, uint32_t index
     ESP_RETURN_ON_FALSE(component_fmt.format.num_components == 4, ESP_ERR_INVALID_ARG, TAG, "led doesn't have 4 components");
 
     // LED_PIXEL_FORMAT_GRBW takes 96bits(12bytes)
-    uint32_t start = index * spi_strip->bytes_per_pixel * SPI_BYTES_PER_COLOR_BYTE;
-    uint8_t *pixel_buf = spi_strip->pixel_buf;
-    memset(pixel_buf + start, 0, spi_strip->bytes_per_pixel * SPI_BYTES_PER_COLOR_BYTE);
+    uint32_t start = index * spi_strip->bytes_per_pixel;
+
+    led_strip_spi_set_byte(spi_strip, start + component_fmt.format.r_pos, red & 0xFF);
+    led_strip_spi_set_byte(spi_strip, start + component_fmt.format.g_pos, green & 0xFF);
+    led_strip_spi_set_byte(spi_strip, start + component_fmt.format.b_pos, blue & 0xFF);
+    led_strip_spi_set_byte(spi_strip, start + component_fmt.format.w_pos, white & 0xFF);
+
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_spi_set_pixels(led_strip_t *strip, uint32_t start, uint32_t count, const led_strip_rgb_t *colors)
+{
+    led_strip_spi_obj *spi_strip = __containerof(strip, led_strip_spi_obj, base);
+    ESP_RETURN_ON_FALSE(start <= spi_strip->strip_len && count <= spi_strip->strip_len - start, ESP_ERR_INVALID_ARG, TAG,
+                        "pixels out of maximum number of LEDs");
+
+    // the format is decoded once for the whole span
+    led_color_component_format_t component_fmt = spi_strip->component_fmt;
+    uint32_t r_pos = component_fmt.format.r_pos * SPI_BYTES_PER_COLOR_BYTE;
+    uint32_t g_pos = component_fmt.format.g_pos * SPI_BYTES_PER_COLOR_BYTE;
+    uint32_t b_pos = component_fmt.format.b_pos * SPI_BYTES_PER_COLOR_BYTE;
+    uint32_t pixel_size = spi_strip->bytes_per_pixel * SPI_BYTES_PER_COLOR_BYTE;
+    uint8_t *buf = spi_strip->pixel_buf + start * pixel_size;
+    uint8_t changed = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        changed |= led_strip_spi_store(buf + r_pos, colors[i].red);
+        changed |= led_strip_spi_store(buf + g_pos, colors[i].green);
+        changed |= led_strip_spi_store(buf + b_pos, colors[i].blue);
+        buf += pixel_size;
+    }
+    if (component_fmt.format.num_components > 3) {
+        uint32_t w_pos = component_fmt.format.w_pos * SPI_BYTES_PER_COLOR_BYTE;
+        buf = spi_strip->pixel_buf + start * pixel_size;
+        for (uint32_t i = 0; i < count; i++) {
+            changed |= led_strip_spi_store(buf + w_pos, 0);
+            buf += pixel_size;
+        }
+    }
+    if (changed) {
+        spi_strip->dirty = true;
+    }
 
-    __led_strip_spi_bit(red, &pixel_buf[start + SPI_BYTES_PER_COLOR_BYTE * component_fmt.format.r_pos]);
-    __led_strip_spi_bit(green, &pixel_buf[start + SPI_BYTES_PER_COLOR_BYTE * component_fmt.format.g_pos]);
-    __led_strip_spi_bit(blue, &pixel_buf[start + SPI_BYTES_PER_COLOR_BYTE * component_fmt.format.b_pos]);
-    __led_strip_spi_bit(white, &pixel_buf[start + SPI_BYTES_PER_COLOR_BYTE * component_fmt.format.w_pos]);
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_spi_set_pixels_raw(led_strip_t *strip, uint32_t start, uint32_t count, const uint8_t *data)
+{
+    led_strip_spi_obj *spi_strip = __containerof(strip, led_strip_spi_obj, base);
+    ESP_RETURN_ON_FALSE(start <= spi_strip->strip_len && count <= spi_strip->strip_len - start, ESP_ERR_INVALID_ARG, TAG,
+                        "pixels out of maximum number of LEDs");
+
+    uint8_t *buf = spi_strip->pixel_buf + start * spi_strip->bytes_per_pixel * SPI_BYTES_PER_COLOR_BYTE;
+    size_t size = count * spi_strip->bytes_per_pixel;
+    uint8_t changed = 0;
+    for (size_t i = 0; i < size; i++) {
+        changed |= led_strip_spi_store(buf, data[i]);
+        buf += SPI_BYTES_PER_COLOR_BYTE;
+    }
+    if (changed) {
+        spi_strip->dirty = true;
+    }
 
     return ESP_OK;
 }
@@ -93,10 +150,18 @@ static esp_err_t led_strip_spi_refresh(led_strip_t *strip)
     spi_transaction_t tx_conf;
     memset(&tx_conf, 0, sizeof(tx_conf));
 
+    // the LEDs already show this frame
+    if (!spi_strip->dirty) {
+        spi_strip->stats.skipped_refreshes++;
+        return ESP_OK;
+    }
+
     tx_conf.length = spi_strip->strip_len * spi_strip->bytes_per_pixel * SPI_BITS_PER_COLOR_BYTE;
     tx_conf.tx_buffer = spi_strip->pixel_buf;
     tx_conf.rx_buffer = NULL;
     ESP_RETURN_ON_ERROR(spi_device_transmit(spi_strip->spi_device, &tx_conf), TAG, "transmit pixels by SPI failed");
+    spi_strip->dirty = false;
+    spi_strip->stats.refreshes++;
 
     return ESP_OK;
 }
@@ -105,16 +170,20 @@ static esp_err_t led_strip_spi_clear(led_strip_t *strip)
 {
     led_strip_spi_obj *spi_strip = __containerof(strip, led_strip_spi_obj, base);
     //Write zero to turn off all leds
-    memset(spi_strip->pixel_buf, 0, spi_strip->strip_len * spi_strip->bytes_per_pixel * SPI_BYTES_PER_COLOR_BYTE);
-    uint8_t *buf = spi_strip->pixel_buf;
-    for (int index = 0; index < spi_strip->strip_len * spi_strip->bytes_per_pixel; index++) {
-        __led_strip_spi_bit(0, buf);
-        buf += SPI_BYTES_PER_COLOR_BYTE;
+    for (uint32_t i = 0; i < spi_strip->strip_len * spi_strip->bytes_per_pixel; i++) {
+        led_strip_spi_set_byte(spi_strip, i, 0);
     }
 
     return led_strip_spi_refresh(strip);
 }
 
+static esp_err_t led_strip_spi_get_stats(led_strip_t *strip, led_strip_stats_t *stats)
+{
+    led_strip_spi_obj *spi_strip = __containerof(strip, led_strip_spi_obj, base);
+    *stats = spi_strip->stats;
+    return ESP_OK;
+}
+
 static esp_err_t led_strip_spi_del(led_strip_t *strip)
 {
     led_strip_spi_obj *spi_strip = __containerof(strip, led_strip_spi_obj, base);
@@ -208,10 +277,19 @@ esp_err_t led_strip_new_spi_device(const led_strip_config_t *led_config, const l
     spi_strip->component_fmt = component_fmt;
     spi_strip->bytes_per_pixel = bytes_per_pixel;
     spi_strip->strip_len = led_config->max_leds;
+    // start from a dark frame, a zeroed buffer is not a valid bit pattern
+    for (uint32_t i = 0; i < spi_strip->strip_len * bytes_per_pixel; i++) {
+        memcpy(&spi_strip->pixel_buf[i * SPI_BYTES_PER_COLOR_BYTE], led_strip_spi_lut[0], SPI_BYTES_PER_COLOR_BYTE);
+    }
+    // whatever the LEDs show at power on, the first refresh has to send the frame
+    spi_strip->dirty = true;
     spi_strip->base.set_pixel = led_strip_spi_set_pixel;
     spi_strip->base.set_pixel_rgbw = led_strip_spi_set_pixel_rgbw;
+    spi_strip->base.set_pixels = led_strip_spi_set_pixels;
+    spi_strip->base.set_pixels_raw = led_strip_spi_set_pixels_raw;
     spi_strip->base.refresh = led_strip_spi_refresh;
     spi_strip->base.clear = led_strip_spi_clear;
+    spi_strip->base.get_stats = led_strip_spi_get_stats;
     spi_strip->base.del = led_strip_spi_del;
 
     *ret_strip = &spi_strip->base;
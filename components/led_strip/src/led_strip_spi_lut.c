@@ -0,0 +1,27 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "led_strip_spi_lut.h"
+
+// 3 SPI bits of a color bit, 110 is a long high level, 100 a short one
+#define LUT_BIT(byte, bit) ((((byte) >> (bit)) & 1) ? 0x6u : 0x4u)
+#define LUT_PATTERN(byte) \
+    (LUT_BIT(byte, 7) << 21 | LUT_BIT(byte, 6) << 18 | LUT_BIT(byte, 5) << 15 | LUT_BIT(byte, 4) << 12 | \
+     LUT_BIT(byte, 3) << 9 | LUT_BIT(byte, 2) << 6 | LUT_BIT(byte, 1) << 3 | LUT_BIT(byte, 0))
+// SPI sends the most significant bit of each byte first
+#define LUT_BYTE(byte) { \
+    (uint8_t)(LUT_PATTERN(byte) >> 16), (uint8_t)(LUT_PATTERN(byte) >> 8), (uint8_t)LUT_PATTERN(byte) }
+#define LUT_16(byte) \
+    LUT_BYTE((byte) + 0), LUT_BYTE((byte) + 1), LUT_BYTE((byte) + 2), LUT_BYTE((byte) + 3), \
+    LUT_BYTE((byte) + 4), LUT_BYTE((byte) + 5), LUT_BYTE((byte) + 6), LUT_BYTE((byte) + 7), \
+    LUT_BYTE((byte) + 8), LUT_BYTE((byte) + 9), LUT_BYTE((byte) + 10), LUT_BYTE((byte) + 11), \
+    LUT_BYTE((byte) + 12), LUT_BYTE((byte) + 13), LUT_BYTE((byte) + 14), LUT_BYTE((byte) + 15)
+
+const uint8_t led_strip_spi_lut[256][LED_STRIP_SPI_BYTES_PER_COLOR_BYTE] = {
+    LUT_16(0x00), LUT_16(0x10), LUT_16(0x20), LUT_16(0x30),
+    LUT_16(0x40), LUT_16(0x50), LUT_16(0x60), LUT_16(0x70),
+    LUT_16(0x80), LUT_16(0x90), LUT_16(0xA0), LUT_16(0xB0),
+    LUT_16(0xC0), LUT_16(0xD0), LUT_16(0xE0), LUT_16(0xF0),
+};
@@ -0,0 +1,15 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include <stdio.h>
+#include "unity.h"
+
+void app_main(void)
+{
+    printf("LED strip test app\n");
+
+    unity_run_menu();
+}
@@ -0,0 +1,93 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include "unity.h"
+#include "led_strip_pixel_pipeline.h"
+
+#define TEST_BYTES 256
+
+TEST_CASE("pixel pipeline at full brightness leaves the bytes as they are", "[led_strip]")
+{
+    static uint8_t in[TEST_BYTES];
+    static uint8_t out[TEST_BYTES];
+    led_strip_pixel_pipeline_t pipeline;
+    led_strip_pixel_pipeline_init(&pipeline, TEST_BYTES);
+    for (int i = 0; i < TEST_BYTES; i++) {
+        in[i] = i;
+    }
+    led_strip_pixel_pipeline_apply(&pipeline, in, out);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(in, out, TEST_BYTES);
+
+    // dithering has nothing to spread without a fraction
+    led_strip_pixel_pipeline_config_t config = {
+        .brightness = 255,
+        .flags.dither = true,
+    };
+    TEST_ESP_OK(led_strip_pixel_pipeline_config(&pipeline, &config));
+    led_strip_pixel_pipeline_apply(&pipeline, in, out);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(in, out, TEST_BYTES);
+    led_strip_pixel_pipeline_deinit(&pipeline);
+}
+
+TEST_CASE("pixel pipeline gamma and brightness", "[led_strip]")
+{
+    static uint8_t in[TEST_BYTES];
+    static uint8_t out[TEST_BYTES];
+    led_strip_pixel_pipeline_t pipeline;
+    led_strip_pixel_pipeline_init(&pipeline, TEST_BYTES);
+    for (int i = 0; i < TEST_BYTES; i++) {
+        in[i] = i;
+    }
+
+    led_strip_pixel_pipeline_config_t config = {
+        .brightness = 128,
+    };
+    TEST_ESP_OK(led_strip_pixel_pipeline_config(&pipeline, &config));
+    led_strip_pixel_pipeline_apply(&pipeline, in, out);
+    for (int i = 0; i < TEST_BYTES; i++) {
+        TEST_ASSERT_EQUAL_UINT8((i * 128 + 127) / 255, out[i]);
+    }
+
+    config.brightness = 255;
+    config.flags.gamma = true;
+    TEST_ESP_OK(led_strip_pixel_pipeline_config(&pipeline, &config));
+    led_strip_pixel_pipeline_apply(&pipeline, in, out);
+    TEST_ASSERT_EQUAL_UINT8(0, out[0]);
+    TEST_ASSERT_EQUAL_UINT8(255, out[255]);
+    // (128 / 255) ^ 2.2 * 255
+    TEST_ASSERT_EQUAL_UINT8(56, out[128]);
+    for (int i = 1; i < TEST_BYTES; i++) {
+        TEST_ASSERT_GREATER_OR_EQUAL(out[i - 1], out[i]);
+    }
+    led_strip_pixel_pipeline_deinit(&pipeline);
+}
+
+TEST_CASE("pixel pipeline dithering averages to the exact level", "[led_strip]")
+{
+    uint8_t in[3] = {1, 20, 255};
+    uint8_t out[3];
+    uint32_t sums[3] = {0};
+    led_strip_pixel_pipeline_t pipeline;
+    led_strip_pixel_pipeline_init(&pipeline, sizeof(in));
+    led_strip_pixel_pipeline_config_t config = {
+        .brightness = 100,
+        .flags.dither = true,
+    };
+    TEST_ESP_OK(led_strip_pixel_pipeline_config(&pipeline, &config));
+    // over 256 frames the residual goes all the way round, the sum is the 8.8 level
+    for (int frame = 0; frame < 256; frame++) {
+        led_strip_pixel_pipeline_apply(&pipeline, in, out);
+        for (int i = 0; i < 3; i++) {
+            sums[i] += out[i];
+        }
+    }
+    for (int i = 0; i < 3; i++) {
+        TEST_ASSERT_UINT32_WITHIN(1, pipeline.lut[in[i]], sums[i]);
+    }
+    // 1 * 100 / 255 rounds to 0 without dithering, but shows up once in a while with it
+    TEST_ASSERT_GREATER_THAN_UINT32(0, sums[0]);
+    led_strip_pixel_pipeline_deinit(&pipeline);
+}
@@ -0,0 +1,339 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include <stdio.h>
+#include <inttypes.h>
+#include "unity.h"
+#include "esp_timer.h"
+#include "esp_cpu.h"
+#include "soc/soc_caps.h"
+#include "led_strip.h"
+
+#define TEST_LED_GPIO 2
+#define TEST_LEDS     30
+#define TEST_ROUNDS   100
+
+static led_strip_handle_t test_new_rmt_strip_on(int gpio_num, uint32_t max_leds)
+{
+    led_strip_config_t strip_config = {
+        .strip_gpio_num = gpio_num,
+        .max_leds = max_leds,
+        .led_model = LED_MODEL_WS2812,
+        .color_component_format = LED_STRIP_COLOR_COMPONENT_FMT_GRB,
+    };
+    led_strip_rmt_config_t rmt_config = {
+        .clk_src = RMT_CLK_SRC_DEFAULT,
+    };
+    led_strip_handle_t strip = NULL;
+    TEST_ESP_OK(led_strip_new_rmt_device(&strip_config, &rmt_config, &strip));
+    return strip;
+}
+
+static led_strip_handle_t test_new_rmt_strip(void)
+{
+    return test_new_rmt_strip_on(TEST_LED_GPIO, TEST_LEDS);
+}
+
+TEST_CASE("rmt strip asynchronous refresh overlaps the next frame", "[led_strip]")
+{
+    led_strip_handle_t strip = test_new_rmt_strip();
+    led_strip_stats_t stats;
+    // nothing to wait for yet
+    TEST_ESP_OK(led_strip_refresh_wait_done(strip, 0));
+
+    for (int frame = 0; frame < 10; frame++) {
+        int64_t start_us = esp_timer_get_time();
+        TEST_ESP_OK(led_strip_refresh_async(strip));
+        int64_t return_us = esp_timer_get_time() - start_us;
+        // the next frame is drawn while this one is sent, 1.2 us per bit plus the reset code
+        // every frame differs from the one before, so none is skipped as unchanged
+        for (uint32_t i = 0; i < TEST_LEDS; i++) {
+            TEST_ESP_OK(led_strip_set_pixel(strip, i, frame + 1, 2 * (frame + 1), 3 * (frame + 1)));
+        }
+        TEST_ESP_OK(led_strip_refresh_wait_done(strip, 100));
+        int64_t frame_us = esp_timer_get_time() - start_us;
+        TEST_ESP_OK(led_strip_get_stats(strip, &stats));
+        TEST_ASSERT_EQUAL_UINT32(frame + 1, stats.refreshes);
+        TEST_ASSERT_EQUAL_UINT32(0, stats.skipped_refreshes);
+        TEST_ASSERT_LESS_THAN(frame_us, return_us);
+        printf("frame %d: returned after %"PRId64" us, sent after %"PRId64" us\n", frame, return_us, frame_us);
+    }
+
+    // the blocking refresh still works once the channel is kept enabled
+    TEST_ESP_OK(led_strip_refresh(strip));
+    TEST_ESP_OK(led_strip_clear(strip));
+    TEST_ESP_OK(led_strip_del(strip));
+}
+
+TEST_CASE("rmt strip blocking refresh", "[led_strip]")
+{
+    led_strip_handle_t strip = test_new_rmt_strip();
+    for (uint32_t i = 0; i < TEST_LEDS; i++) {
+        TEST_ESP_OK(led_strip_set_pixel(strip, i, 10, 20, 30));
+    }
+    TEST_ESP_OK(led_strip_refresh(strip));
+    TEST_ESP_OK(led_strip_refresh(strip));
+    TEST_ESP_OK(led_strip_refresh_wait_done(strip, 0));
+    TEST_ESP_OK(led_strip_del(strip));
+}
+
+TEST_CASE("rmt strip refresh is skipped when no pixel changed", "[led_strip]")
+{
+    led_strip_handle_t strip = test_new_rmt_strip();
+    led_strip_stats_t stats;
+    // the first frame is always sent, the LEDs may show anything at power on
+    TEST_ESP_OK(led_strip_refresh(strip));
+    TEST_ESP_OK(led_strip_refresh(strip));
+    TEST_ESP_OK(led_strip_get_stats(strip, &stats));
+    TEST_ASSERT_EQUAL_UINT32(1, stats.refreshes);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.skipped_refreshes);
+
+    // setting a pixel to the color it already has doesn't make a new frame
+    TEST_ESP_OK(led_strip_set_pixel(strip, 0, 0, 0, 0));
+    TEST_ESP_OK(led_strip_refresh(strip));
+    TEST_ESP_OK(led_strip_set_pixel(strip, 0, 1, 2, 3));
+    TEST_ESP_OK(led_strip_refresh_async(strip));
+    TEST_ESP_OK(led_strip_refresh_wait_done(strip, 100));
+    TEST_ESP_OK(led_strip_get_stats(strip, &stats));
+    TEST_ASSERT_EQUAL_UINT32(2, stats.refreshes);
+    TEST_ASSERT_EQUAL_UINT32(2, stats.skipped_refreshes);
+
+    // clearing a lit strip sends the dark frame once
+    TEST_ESP_OK(led_strip_clear(strip));
+    TEST_ESP_OK(led_strip_clear(strip));
+    TEST_ESP_OK(led_strip_get_stats(strip, &stats));
+    TEST_ASSERT_EQUAL_UINT32(3, stats.refreshes);
+    TEST_ASSERT_EQUAL_UINT32(3, stats.skipped_refreshes);
+
+    // dithering at full brightness without gamma has no fraction to spread, unchanged frames are still skipped
+    led_strip_pixel_pipeline_config_t pipeline_config = {
+        .brightness = 255,
+        .flags.dither = true,
+    };
+    TEST_ESP_OK(led_strip_set_pixel_pipeline(strip, &pipeline_config));
+    // a new pipeline makes a new frame once
+    TEST_ESP_OK(led_strip_refresh(strip));
+    TEST_ESP_OK(led_strip_refresh(strip));
+    TEST_ESP_OK(led_strip_refresh(strip));
+    TEST_ESP_OK(led_strip_get_stats(strip, &stats));
+    TEST_ASSERT_EQUAL_UINT32(4, stats.refreshes);
+    TEST_ASSERT_EQUAL_UINT32(5, stats.skipped_refreshes);
+    TEST_ESP_OK(led_strip_del(strip));
+}
+
+TEST_CASE("rmt strip pixel spans match single pixels", "[led_strip]")
+{
+    led_strip_handle_t strip = test_new_rmt_strip();
+    led_strip_rgb_t colors[TEST_LEDS];
+    uint8_t raw[TEST_LEDS * 3];
+    led_strip_stats_t stats;
+    for (uint32_t i = 0; i < TEST_LEDS; i++) {
+        colors[i] = (led_strip_rgb_t) {
+            .red = i, .green = 2 * i, .blue = 3 * i,
+        };
+        // GRB order
+        raw[i * 3 + 0] = colors[i].green;
+        raw[i * 3 + 1] = colors[i].red;
+        raw[i * 3 + 2] = colors[i].blue;
+        TEST_ESP_OK(led_strip_set_pixel(strip, i, colors[i].red, colors[i].green, colors[i].blue));
+    }
+    TEST_ESP_OK(led_strip_refresh(strip));
+
+    // the same colors written again as spans leave the frame unchanged, nothing is sent
+    TEST_ESP_OK(led_strip_set_pixels(strip, 0, TEST_LEDS, colors));
+    TEST_ESP_OK(led_strip_refresh(strip));
+    TEST_ESP_OK(led_strip_set_pixels_raw(strip, 0, TEST_LEDS, raw));
+    TEST_ESP_OK(led_strip_set_pixels(strip, 10, 0, colors));
+    TEST_ESP_OK(led_strip_refresh(strip));
+    TEST_ESP_OK(led_strip_get_stats(strip, &stats));
+    TEST_ASSERT_EQUAL_UINT32(1, stats.refreshes);
+    TEST_ASSERT_EQUAL_UINT32(2, stats.skipped_refreshes);
+
+    TEST_ESP_OK(led_strip_set_pixels(strip, TEST_LEDS - 1, 1, colors));
+    TEST_ESP_OK(led_strip_refresh(strip));
+    TEST_ESP_OK(led_strip_get_stats(strip, &stats));
+    TEST_ASSERT_EQUAL_UINT32(2, stats.refreshes);
+
+    // spans are checked once, before any pixel is written
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, led_strip_set_pixels(strip, TEST_LEDS - 1, 2, colors));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, led_strip_set_pixels(strip, UINT32_MAX, 2, colors));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, led_strip_set_pixels_raw(strip, 1, TEST_LEDS, raw));
+    TEST_ESP_OK(led_strip_del(strip));
+}
+
+TEST_CASE("rmt strip full strip update cycles per pixel", "[led_strip][bench]")
+{
+    led_strip_handle_t strip = test_new_rmt_strip();
+    static led_strip_rgb_t colors[TEST_LEDS];
+    static uint8_t raw[TEST_LEDS * 3];
+
+    uint32_t start = esp_cpu_get_cycle_count();
+    for (int round = 0; round < TEST_ROUNDS; round++) {
+        for (uint32_t i = 0; i < TEST_LEDS; i++) {
+            TEST_ESP_OK(led_strip_set_pixel(strip, i, round, i, 2 * i));
+        }
+    }
+    uint32_t pixel_cycles = esp_cpu_get_cycle_count() - start;
+
+    start = esp_cpu_get_cycle_count();
+    for (int round = 0; round < TEST_ROUNDS; round++) {
+        colors[0].red = round;
+        TEST_ESP_OK(led_strip_set_pixels(strip, 0, TEST_LEDS, colors));
+    }
+    uint32_t span_cycles = esp_cpu_get_cycle_count() - start;
+
+    start = esp_cpu_get_cycle_count();
+    for (int round = 0; round < TEST_ROUNDS; round++) {
+        raw[0] = round;
+        TEST_ESP_OK(led_strip_set_pixels_raw(strip, 0, TEST_LEDS, raw));
+    }
+    uint32_t raw_cycles = esp_cpu_get_cycle_count() - start;
+
+    printf("set_pixel:      %"PRIu32" cycles/pixel\n", pixel_cycles / (TEST_ROUNDS * TEST_LEDS));
+    printf("set_pixels:     %"PRIu32" cycles/pixel\n", span_cycles / (TEST_ROUNDS * TEST_LEDS));
+    printf("set_pixels_raw: %"PRIu32" cycles/pixel\n", raw_cycles / (TEST_ROUNDS * TEST_LEDS));
+    TEST_ASSERT_LESS_THAN_UINT32(pixel_cycles, span_cycles);
+    TEST_ESP_OK(led_strip_del(strip));
+}
+
+#if SOC_RMT_SUPPORT_TX_SYNCHRO
+TEST_CASE("rmt strip group sends its strips in parallel", "[led_strip]")
+{
+    // a key grid and a shorter edge strip
+    led_strip_handle_t strips[2] = {
+        test_new_rmt_strip_on(TEST_LED_GPIO, TEST_LEDS),
+        test_new_rmt_strip_on(TEST_LED_GPIO + 1, TEST_LEDS / 3),
+    };
+    led_strip_rmt_group_handle_t group = NULL;
+    led_strip_stats_t stats;
+
+    // one after the other, the frame takes as long as both strips
+    int64_t start_us = esp_timer_get_time();
+    for (int i = 0; i < 2; i++) {
+        TEST_ESP_OK(led_strip_set_pixel(strips[i], 0, 1, 2, 3));
+        TEST_ESP_OK(led_strip_refresh(strips[i]));
+    }
+    int64_t serial_us = esp_timer_get_time() - start_us;
+
+    TEST_ESP_OK(led_strip_rmt_new_group(strips, 2, &group));
+    // a grouped strip can't be grouped again or deleted
+    led_strip_rmt_group_handle_t other_group = NULL;
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, led_strip_rmt_new_group(&strips[1], 1, &other_group));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, led_strip_del(strips[0]));
+
+    // together, as long as the longest strip
+    start_us = esp_timer_get_time();
+    TEST_ESP_OK(led_strip_set_pixel(strips[1], 0, 4, 5, 6));
+    TEST_ESP_OK(led_strip_rmt_group_refresh(group));
+    int64_t group_us = esp_timer_get_time() - start_us;
+    printf("serial: %"PRId64" us, group: %"PRId64" us\n", serial_us, group_us);
+    TEST_ASSERT_LESS_THAN(serial_us, group_us);
+    // both strips were sent, though only one changed
+    TEST_ESP_OK(led_strip_get_stats(strips[0], &stats));
+    TEST_ASSERT_EQUAL_UINT32(2, stats.refreshes);
+
+    // refreshing a strip of the group refreshes the group, one completion for all of it
+    TEST_ESP_OK(led_strip_set_pixel(strips[0], 1, 7, 8, 9));
+    TEST_ESP_OK(led_strip_refresh_async(strips[0]));
+    TEST_ESP_OK(led_strip_rmt_group_wait_done(group, 100));
+    TEST_ESP_OK(led_strip_rmt_group_refresh(group));
+    TEST_ESP_OK(led_strip_get_stats(strips[1], &stats));
+    TEST_ASSERT_EQUAL_UINT32(3, stats.refreshes);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.skipped_refreshes);
+
+    TEST_ESP_OK(led_strip_rmt_del_group(group));
+    for (int i = 0; i < 2; i++) {
+        TEST_ESP_OK(led_strip_clear(strips[i]));
+        TEST_ESP_OK(led_strip_del(strips[i]));
+    }
+}
+#else
+TEST_CASE("rmt strip group needs RMT TX synchronization", "[led_strip]")
+{
+    led_strip_handle_t strips[2] = {
+        test_new_rmt_strip_on(TEST_LED_GPIO, TEST_LEDS),
+        test_new_rmt_strip_on(TEST_LED_GPIO + 1, TEST_LEDS / 3),
+    };
+    led_strip_rmt_group_handle_t group = NULL;
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_SUPPORTED, led_strip_rmt_new_group(strips, 2, &group));
+    // the strips are left as they were, not grouped
+    for (int i = 0; i < 2; i++) {
+        TEST_ESP_OK(led_strip_refresh(strips[i]));
+        TEST_ESP_OK(led_strip_del(strips[i]));
+    }
+}
+#endif
+
+typedef struct {
+    uint32_t next_pixel;
+    uint32_t nr_calls;
+    uint32_t max_count;
+    bool in_order;
+} test_stream_ctx_t;
+
+static void test_stream_generate(uint32_t start, uint32_t count, uint8_t *pixels, void *user_ctx)
+{
+    test_stream_ctx_t *ctx = (test_stream_ctx_t *)user_ctx;
+    ctx->in_order &= start == ctx->next_pixel;
+    ctx->next_pixel = start + count;
+    ctx->nr_calls++;
+    ctx->max_count = count > ctx->max_count ? count : ctx->max_count;
+    for (uint32_t i = 0; i < count * 3; i++) {
+        pixels[i] = start + i;
+    }
+}
+
+TEST_CASE("rmt streamed strip pulls its frames in chunks", "[led_strip]")
+{
+    const uint32_t nr_leds = 1000;
+    const uint32_t chunk_pixels = 8;
+    test_stream_ctx_t ctx = {};
+    led_strip_config_t strip_config = {
+        .strip_gpio_num = TEST_LED_GPIO,
+        .max_leds = nr_leds,
+        .led_model = LED_MODEL_WS2812,
+        .color_component_format = LED_STRIP_COLOR_COMPONENT_FMT_GRB,
+    };
+    led_strip_rmt_config_t rmt_config = {
+        .clk_src = RMT_CLK_SRC_DEFAULT,
+    };
+    led_strip_rmt_stream_config_t stream_config = {
+        .generator = test_stream_generate,
+        .user_ctx = &ctx,
+        .chunk_pixels = chunk_pixels,
+    };
+    led_strip_handle_t strip = NULL;
+    led_strip_stats_t stats;
+    TEST_ESP_OK(led_strip_new_rmt_stream_device(&strip_config, &rmt_config, &stream_config, &strip));
+    // no pixel buffer to set
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_SUPPORTED, led_strip_set_pixel(strip, 0, 1, 2, 3));
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_SUPPORTED, led_strip_set_pixels_raw(strip, 0, 1, (const uint8_t[3]) {0}));
+
+    for (int frame = 0; frame < 2; frame++) {
+        ctx = (test_stream_ctx_t) {
+            .in_order = true,
+        };
+        int64_t start_us = esp_timer_get_time();
+        TEST_ESP_OK(led_strip_refresh(strip));
+        int64_t frame_us = esp_timer_get_time() - start_us;
+        printf("frame %d: %"PRIu32" chunks in %"PRId64" us\n", frame, ctx.nr_calls, frame_us);
+        // every pixel pulled once, in order, never more than a chunk at a time
+        TEST_ASSERT_TRUE(ctx.in_order);
+        TEST_ASSERT_EQUAL_UINT32(nr_leds, ctx.next_pixel);
+        TEST_ASSERT_EQUAL_UINT32(chunk_pixels, ctx.max_count);
+        TEST_ASSERT_EQUAL_UINT32((nr_leds + chunk_pixels - 1) / chunk_pixels, ctx.nr_calls);
+        // 1.2 us per bit, the refills kept up with the wire
+        TEST_ASSERT_LESS_THAN(nr_leds * 24 * 12 / 10 + 1000, frame_us);
+    }
+
+    // clearing sends a dark frame, the generator isn't asked for it
+    ctx.nr_calls = 0;
+    TEST_ESP_OK(led_strip_clear(strip));
+    TEST_ASSERT_EQUAL_UINT32(0, ctx.nr_calls);
+    TEST_ESP_OK(led_strip_get_stats(strip, &stats));
+    TEST_ASSERT_EQUAL_UINT32(3, stats.refreshes);
+    TEST_ESP_OK(led_strip_del(strip));
+}
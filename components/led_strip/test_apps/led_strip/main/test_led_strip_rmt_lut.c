@@ -0,0 +1,105 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include <stdio.h>
+#include <inttypes.h>
+#include "unity.h"
+#include "esp_cpu.h"
+#include "led_strip_rmt_lut.h"
+
+#define TEST_LEDS            30
+#define TEST_BYTES_PER_PIXEL 3
+#define TEST_ROUNDS          100
+
+typedef struct {
+    uint32_t t0h_ns;
+    uint32_t t0l_ns;
+    uint32_t t1h_ns;
+    uint32_t t1l_ns;
+} test_timing_t;
+
+static const test_timing_t s_ws2812_timing = {
+    LED_STRIP_WS2812_T0H_NS, LED_STRIP_WS2812_T0L_NS, LED_STRIP_WS2812_T1H_NS, LED_STRIP_WS2812_T1L_NS,
+};
+
+static const test_timing_t s_sk6812_timing = {
+    LED_STRIP_SK6812_T0H_NS, LED_STRIP_SK6812_T0L_NS, LED_STRIP_SK6812_T1H_NS, LED_STRIP_SK6812_T1L_NS,
+};
+
+// Encode one byte bit by bit, the way the symbols were built before there was a table
+static void test_encode_byte_bitwise(const test_timing_t *timing, uint32_t resolution, uint8_t value, rmt_symbol_word_t *symbols)
+{
+    for (int i = 0; i < 8; i++) {
+        bool one = value & (1 << (7 - i));
+        symbols[i].level0 = 1;
+        symbols[i].duration0 = LED_STRIP_RMT_TICKS(resolution, one ? timing->t1h_ns : timing->t0h_ns);
+        symbols[i].level1 = 0;
+        symbols[i].duration1 = LED_STRIP_RMT_TICKS(resolution, one ? timing->t1l_ns : timing->t0l_ns);
+    }
+}
+
+static void test_check_lut(led_model_t led_model, const test_timing_t *timing)
+{
+    const led_strip_rmt_lut_t *lut = led_strip_rmt_lut_get(led_model, LED_STRIP_RMT_LUT_RESOLUTION);
+    TEST_ASSERT_NOT_NULL(lut);
+    for (int value = 0; value < 256; value++) {
+        rmt_symbol_word_t expected[8];
+        test_encode_byte_bitwise(timing, LED_STRIP_RMT_LUT_RESOLUTION, value, expected);
+        TEST_ASSERT_EQUAL_HEX32_ARRAY(&expected[0].val, &(*lut)[value][0].val, 8);
+    }
+}
+
+TEST_CASE("rmt symbol tables match the bit timings", "[led_strip]")
+{
+    test_check_lut(LED_MODEL_WS2812, &s_ws2812_timing);
+    test_check_lut(LED_MODEL_SK6812, &s_sk6812_timing);
+    // the tables are built for one resolution only, the encoder falls back to the bytes encoder otherwise
+    TEST_ASSERT_NULL(led_strip_rmt_lut_get(LED_MODEL_WS2812, LED_STRIP_RMT_LUT_RESOLUTION / 2));
+    TEST_ASSERT_NULL(led_strip_rmt_lut_get(LED_MODEL_INVALID, LED_STRIP_RMT_LUT_RESOLUTION));
+}
+
+TEST_CASE("rmt symbol table encoding matches bit by bit encoding", "[led_strip]")
+{
+    static uint8_t pixels[TEST_LEDS * TEST_BYTES_PER_PIXEL];
+    static rmt_symbol_word_t expected[TEST_LEDS * TEST_BYTES_PER_PIXEL * 8];
+    static rmt_symbol_word_t symbols[TEST_LEDS * TEST_BYTES_PER_PIXEL * 8];
+    for (size_t i = 0; i < sizeof(pixels); i++) {
+        pixels[i] = i * 37 + 11;
+        test_encode_byte_bitwise(&s_ws2812_timing, LED_STRIP_RMT_LUT_RESOLUTION, pixels[i], &expected[i * 8]);
+    }
+    led_strip_rmt_lut_encode(led_strip_rmt_lut_get(LED_MODEL_WS2812, LED_STRIP_RMT_LUT_RESOLUTION), pixels, sizeof(pixels), symbols);
+    TEST_ASSERT_EQUAL_HEX32_ARRAY(&expected[0].val, &symbols[0].val, sizeof(pixels) * 8);
+}
+
+TEST_CASE("rmt symbol encoding cycles per pixel", "[led_strip][bench]")
+{
+    static uint8_t pixels[TEST_LEDS * TEST_BYTES_PER_PIXEL];
+    static rmt_symbol_word_t symbols[TEST_LEDS * TEST_BYTES_PER_PIXEL * 8];
+    const led_strip_rmt_lut_t *lut = led_strip_rmt_lut_get(LED_MODEL_WS2812, LED_STRIP_RMT_LUT_RESOLUTION);
+    // the resolution is only known at run time on the bit by bit path, as in the bytes encoder
+    volatile uint32_t resolution = LED_STRIP_RMT_LUT_RESOLUTION;
+    for (size_t i = 0; i < sizeof(pixels); i++) {
+        pixels[i] = i * 37 + 11;
+    }
+
+    uint32_t start = esp_cpu_get_cycle_count();
+    for (int round = 0; round < TEST_ROUNDS; round++) {
+        for (size_t i = 0; i < sizeof(pixels); i++) {
+            test_encode_byte_bitwise(&s_ws2812_timing, resolution, pixels[i], &symbols[i * 8]);
+        }
+    }
+    uint32_t bitwise_cycles = esp_cpu_get_cycle_count() - start;
+
+    start = esp_cpu_get_cycle_count();
+    for (int round = 0; round < TEST_ROUNDS; round++) {
+        led_strip_rmt_lut_encode(lut, pixels, sizeof(pixels), symbols);
+    }
+    uint32_t lut_cycles = esp_cpu_get_cycle_count() - start;
+
+    printf("bit by bit: %"PRIu32" cycles/pixel\n", bitwise_cycles / (TEST_ROUNDS * TEST_LEDS));
+    printf("table:      %"PRIu32" cycles/pixel\n", lut_cycles / (TEST_ROUNDS * TEST_LEDS));
+    TEST_ASSERT_LESS_THAN_UINT32(bitwise_cycles, lut_cycles);
+}
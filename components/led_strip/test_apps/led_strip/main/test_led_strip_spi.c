@@ -0,0 +1,122 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include <stdio.h>
+#include <inttypes.h>
+#include "unity.h"
+#include "esp_cpu.h"
+#include "led_strip.h"
+
+#define TEST_LED_GPIO 2
+#define TEST_LEDS     30
+#define TEST_ROUNDS   100
+
+static led_strip_handle_t test_new_spi_strip(void)
+{
+    led_strip_config_t strip_config = {
+        .strip_gpio_num = TEST_LED_GPIO,
+        .max_leds = TEST_LEDS,
+        .led_model = LED_MODEL_WS2812,
+        .color_component_format = LED_STRIP_COLOR_COMPONENT_FMT_GRB,
+    };
+    led_strip_spi_config_t spi_config = {
+        .clk_src = SPI_CLK_SRC_DEFAULT,
+        .spi_bus = SPI2_HOST,
+        .flags.with_dma = true,
+    };
+    led_strip_handle_t strip = NULL;
+    TEST_ESP_OK(led_strip_new_spi_device(&strip_config, &spi_config, &strip));
+    return strip;
+}
+
+TEST_CASE("spi strip pixel spans match single pixels", "[led_strip]")
+{
+    led_strip_handle_t strip = test_new_spi_strip();
+    led_strip_rgb_t colors[TEST_LEDS];
+    uint8_t raw[TEST_LEDS * 3];
+    led_strip_stats_t stats;
+    for (uint32_t i = 0; i < TEST_LEDS; i++) {
+        colors[i] = (led_strip_rgb_t) {
+            .red = i, .green = 2 * i, .blue = 3 * i,
+        };
+        // GRB order
+        raw[i * 3 + 0] = colors[i].green;
+        raw[i * 3 + 1] = colors[i].red;
+        raw[i * 3 + 2] = colors[i].blue;
+        TEST_ESP_OK(led_strip_set_pixel(strip, i, colors[i].red, colors[i].green, colors[i].blue));
+    }
+    TEST_ESP_OK(led_strip_refresh(strip));
+
+    // the same colors written again as spans store the same SPI patterns, nothing is sent
+    TEST_ESP_OK(led_strip_set_pixels(strip, 0, TEST_LEDS, colors));
+    TEST_ESP_OK(led_strip_refresh(strip));
+    TEST_ESP_OK(led_strip_set_pixels_raw(strip, 0, TEST_LEDS, raw));
+    TEST_ESP_OK(led_strip_set_pixels(strip, 10, 0, colors));
+    TEST_ESP_OK(led_strip_refresh(strip));
+    TEST_ESP_OK(led_strip_get_stats(strip, &stats));
+    TEST_ASSERT_EQUAL_UINT32(1, stats.refreshes);
+    TEST_ASSERT_EQUAL_UINT32(2, stats.skipped_refreshes);
+
+    TEST_ESP_OK(led_strip_set_pixels(strip, TEST_LEDS - 1, 1, colors));
+    TEST_ESP_OK(led_strip_refresh(strip));
+    TEST_ESP_OK(led_strip_get_stats(strip, &stats));
+    TEST_ASSERT_EQUAL_UINT32(2, stats.refreshes);
+
+    // a raw span changing a single color byte is enough to send the frame again
+    raw[5] ^= 0x80;
+    TEST_ESP_OK(led_strip_set_pixels_raw(strip, 0, 2, raw));
+    TEST_ESP_OK(led_strip_refresh(strip));
+    TEST_ESP_OK(led_strip_get_stats(strip, &stats));
+    TEST_ASSERT_EQUAL_UINT32(3, stats.refreshes);
+    TEST_ASSERT_EQUAL_UINT32(2, stats.skipped_refreshes);
+
+    // spans are checked once, before any pixel is written
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, led_strip_set_pixels(strip, TEST_LEDS - 1, 2, colors));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, led_strip_set_pixels(strip, UINT32_MAX, 2, colors));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, led_strip_set_pixels_raw(strip, 1, TEST_LEDS, raw));
+    TEST_ESP_OK(led_strip_refresh(strip));
+    TEST_ESP_OK(led_strip_get_stats(strip, &stats));
+    TEST_ASSERT_EQUAL_UINT32(3, stats.refreshes);
+    TEST_ASSERT_EQUAL_UINT32(3, stats.skipped_refreshes);
+    TEST_ESP_OK(led_strip_del(strip));
+}
+
+TEST_CASE("spi strip full strip update cycles per pixel", "[led_strip][bench]")
+{
+    led_strip_handle_t strip = test_new_spi_strip();
+    static led_strip_rgb_t colors[TEST_LEDS];
+    static uint8_t raw[TEST_LEDS * 3];
+
+    // every color byte goes through the pattern table into the SPI buffer
+    uint32_t start = esp_cpu_get_cycle_count();
+    for (int round = 0; round < TEST_ROUNDS; round++) {
+        for (uint32_t i = 0; i < TEST_LEDS; i++) {
+            TEST_ESP_OK(led_strip_set_pixel(strip, i, round, i, 2 * i));
+        }
+    }
+    uint32_t pixel_cycles = esp_cpu_get_cycle_count() - start;
+
+    start = esp_cpu_get_cycle_count();
+    for (int round = 0; round < TEST_ROUNDS; round++) {
+        colors[0].red = round;
+        TEST_ESP_OK(led_strip_set_pixels(strip, 0, TEST_LEDS, colors));
+    }
+    uint32_t span_cycles = esp_cpu_get_cycle_count() - start;
+
+    start = esp_cpu_get_cycle_count();
+    for (int round = 0; round < TEST_ROUNDS; round++) {
+        raw[0] = round;
+        TEST_ESP_OK(led_strip_set_pixels_raw(strip, 0, TEST_LEDS, raw));
+    }
+    uint32_t raw_cycles = esp_cpu_get_cycle_count() - start;
+
+    printf("set_pixel:      %"PRIu32" cycles/pixel\n", pixel_cycles / (TEST_ROUNDS * TEST_LEDS));
+    printf("set_pixels:     %"PRIu32" cycles/pixel\n", span_cycles / (TEST_ROUNDS * TEST_LEDS));
+    printf("set_pixels_raw: %"PRIu32" cycles/pixel\n", raw_cycles / (TEST_ROUNDS * TEST_LEDS));
+    TEST_ASSERT_LESS_THAN_UINT32(pixel_cycles, span_cycles);
+    TEST_ESP_OK(led_strip_refresh(strip));
+    TEST_ESP_OK(led_strip_del(strip));
+}
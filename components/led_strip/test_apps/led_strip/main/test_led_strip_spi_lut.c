@@ -0,0 +1,35 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include "unity.h"
+#include "led_strip_spi_lut.h"
+
+// Encode one byte bit by bit into a zeroed buffer, the way the SPI backend did before there was a table
+static void test_encode_byte_bitwise(uint8_t data, uint8_t *buf)
+{
+    buf[2] |= data & (1 << 0) ? (1 << 2) | (1 << 1) : (1 << 2);
+    buf[2] |= data & (1 << 1) ? (1 << 5) | (1 << 4) : (1 << 5);
+    buf[2] |= data & (1 << 2) ? (1 << 7) : 0x00;
+    buf[1] |= (1 << 0);
+    buf[1] |= data & (1 << 3) ? (1 << 3) | (1 << 2) : (1 << 3);
+    buf[1] |= data & (1 << 4) ? (1 << 6) | (1 << 5) : (1 << 6);
+    buf[0] |= data & (1 << 5) ? (1 << 1) | (1 << 0) : (1 << 1);
+    buf[0] |= data & (1 << 6) ? (1 << 4) | (1 << 3) : (1 << 4);
+    buf[0] |= data & (1 << 7) ? (1 << 7) | (1 << 6) : (1 << 7);
+}
+
+TEST_CASE("spi pattern table matches bit by bit encoding", "[led_strip]")
+{
+    for (int value = 0; value < 256; value++) {
+        uint8_t expected[LED_STRIP_SPI_BYTES_PER_COLOR_BYTE] = {0};
+        test_encode_byte_bitwise(value, expected);
+        TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, led_strip_spi_lut[value], LED_STRIP_SPI_BYTES_PER_COLOR_BYTE);
+    }
+    // 0 is sent as 100 100 100 ...
+    TEST_ASSERT_EQUAL_HEX8(0x92, led_strip_spi_lut[0][0]);
+    TEST_ASSERT_EQUAL_HEX8(0x49, led_strip_spi_lut[0][1]);
+    TEST_ASSERT_EQUAL_HEX8(0x24, led_strip_spi_lut[0][2]);
+}
@@ -0,0 +1,114 @@
+/*
+ * SPDX-FileCopyrightText: 2020-2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "matrix_keyboard.h"
+#include "esp_private/matrix_kbd_gesture.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Type of hardware independent matrix keyboard core
+ *
+ * @note The core turns raw scans into events: ghost detection, per-key debounce and gestures.
+ *       It never touches GPIOs nor timers, the backend samples the matrix and feeds each scan with its timestamp,
+ *       so the same code runs on the chip behind dedicated GPIO and on the linux target behind a simulator.
+ */
+typedef struct matrix_kbd_core_t matrix_kbd_core_t;
+
+/**
+ * @brief Callback invoked for each event produced by a scan
+ *
+ * @param[in] id Event ID
+ * @param[in] data Event data, only valid during the call
+ * @param[in] user_ctx User context passed to `matrix_kbd_core_new`
+ */
+typedef void (*matrix_kbd_core_event_cb_t)(matrix_kbd_event_id_t id, const matrix_kbd_event_data_t *data, void *user_ctx);
+
+/**
+ * @brief Configuration of matrix keyboard core
+ */
+typedef struct {
+    uint32_t nr_rows;                    /*!< Number of rows */
+    uint32_t nr_cols;                    /*!< Number of columns, up to 32 */
+    uint32_t debounce_threshold;         /*!< Number of scans needed to change the state of a key, 1 to 255 */
+    matrix_kbd_ghost_mode_t ghost_mode;  /*!< How to handle keys which may be ghosts */
+    matrix_kbd_gesture_config_t gesture; /*!< Gesture timing, all zero disables the gesture engine */
+} matrix_kbd_core_config_t;
+
+/**
+ * @brief Create a matrix keyboard core
+ *
+ * @param[in] config Configuration of the core
+ * @param[in] on_event Callback invoked for each event
+ * @param[in] user_ctx User context passed to `on_event`
+ * @param[out] ret_core Returned core
+ * @return
+ *      - ESP_OK: Create core successfully
+ *      - ESP_ERR_INVALID_ARG: Create core failed because of invalid argument
+ *      - ESP_ERR_NO_MEM: Create core failed because of out of memory
+ */
+esp_err_t matrix_kbd_core_new(const matrix_kbd_core_config_t *config, matrix_kbd_core_event_cb_t on_event, void *user_ctx, matrix_kbd_core_t **ret_core);
+
+/**
+ * @brief Delete a matrix keyboard core
+ *
+ * @param[in] core Core returned from `matrix_kbd_core_new`
+ */
+void matrix_kbd_core_del(matrix_kbd_core_t *core);
+
+/**
+ * @brief Return every key to released and idle, without reporting any event
+ *
+ * @param[in] core Core returned from `matrix_kbd_core_new`
+ * @param[in] now_us Current time, in microseconds
+ */
+void matrix_kbd_core_reset(matrix_kbd_core_t *core, int64_t now_us);
+
+/**
+ * @brief Feed one scan of the matrix
+ *
+ * @param[in] core Core returned from `matrix_kbd_core_new`
+ * @param[in,out] raw_rows Array of `nr_rows` bitmaps, bit N of entry M is set if the key at row M, column N reads pressed,
+ *                         ambiguous keys are overwritten with their previous state in `MATRIX_KBD_GHOST_BLOCK` mode
+ * @param[in] scan_time_us Time of the scan, in microseconds, stamped on the events
+ * @param[in,out] edge_time_us Time of the row edge which woke the scan, handed to the first key down and then cleared, can be NULL
+ * @return True if a key is still pressed or still settling, i.e. scanning must go on
+ */
+bool matrix_kbd_core_scan(matrix_kbd_core_t *core, uint32_t *raw_rows, int64_t scan_time_us, int64_t *edge_time_us);
+
+/**
+ * @brief Get the debounced state of the matrix
+ *
+ * @param[in] core Core returned from `matrix_kbd_core_new`
+ * @return Array of `nr_rows` bitmaps, bit N of entry M is set if the key at row M, column N is pressed
+ */
+const uint32_t *matrix_kbd_core_get_state(const matrix_kbd_core_t *core);
+
+/**
+ * @brief Pack the debounced state of the matrix into one bitmap
+ *
+ * @param[in] core Core returned from `matrix_kbd_core_new`
+ * @param[out] keys Array of `(nr_rows * nr_cols + 31) / 32` words, bit `row * nr_cols + col` is set if the key is pressed
+ */
+void matrix_kbd_core_pack_state(const matrix_kbd_core_t *core, uint32_t *keys);
+
+/**
+ * @brief Get the number of scans which found ambiguous keys
+ *
+ * @param[in] core Core returned from `matrix_kbd_core_new`
+ * @return Number of scans since the last reset
+ */
+uint32_t matrix_kbd_core_get_ghost_scans(const matrix_kbd_core_t *core);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,87 @@
+/*
+ * SPDX-FileCopyrightText: 2020-2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Type of per-key integrating debouncer
+ *
+ * @note Every key owns a small integrator which counts up on each scan that reads the key pressed and down on each scan that reads it released.
+ *       The debounced state only flips when the integrator saturates, at `threshold` for a press and at zero for a release.
+ *       Keys are independent from each other, so bounce on one key never hides edges on another (N-key rollover).
+ *       For contacts that bounce for at most B scans, an edge is reported at most B + threshold scans after it happened.
+ */
+typedef struct matrix_kbd_debounce_t matrix_kbd_debounce_t;
+
+/**
+ * @brief Callback invoked for each debounced key edge
+ *
+ * @param[in] row Row index of the key
+ * @param[in] col Column index of the key
+ * @param[in] pressed True if the key has been pressed, false if it has been released
+ * @param[in] user_ctx User context passed to `matrix_kbd_debounce_update`
+ */
+typedef void (*matrix_kbd_debounce_edge_cb_t)(uint32_t row, uint32_t col, bool pressed, void *user_ctx);
+
+/**
+ * @brief Create a debouncer for a matrix
+ *
+ * @param[in] nr_rows Number of rows
+ * @param[in] nr_cols Number of columns, up to 32
+ * @param[in] threshold Number of scans needed to change the state of a key, 1 to 255
+ * @param[out] ret_debounce Returned debouncer
+ * @return
+ *      - ESP_OK: Create debouncer successfully
+ *      - ESP_ERR_INVALID_ARG: Create debouncer failed because of invalid argument
+ *      - ESP_ERR_NO_MEM: Create debouncer failed because of out of memory
+ */
+esp_err_t matrix_kbd_debounce_new(uint32_t nr_rows, uint32_t nr_cols, uint32_t threshold, matrix_kbd_debounce_t **ret_debounce);
+
+/**
+ * @brief Delete a debouncer
+ *
+ * @param[in] debounce Debouncer returned from `matrix_kbd_debounce_new`
+ */
+void matrix_kbd_debounce_del(matrix_kbd_debounce_t *debounce);
+
+/**
+ * @brief Reset all keys to the released and settled state, without reporting any edge
+ *
+ * @param[in] debounce Debouncer returned from `matrix_kbd_debounce_new`
+ */
+void matrix_kbd_debounce_reset(matrix_kbd_debounce_t *debounce);
+
+/**
+ * @brief Feed one scan of the matrix into the debouncer
+ *
+ * @note Only keys whose raw level differs from the debounced state, or whose integrator hasn't saturated yet, are visited.
+ *
+ * @param[in] debounce Debouncer returned from `matrix_kbd_debounce_new`
+ * @param[in] raw_rows Array of `nr_rows` bitmaps, bit N of entry M is set if the key at row M, column N reads pressed
+ * @param[in] on_edge Callback invoked for each debounced edge, can be NULL
+ * @param[in] user_ctx User context passed to `on_edge`
+ * @return True if a key is still pressed or still settling, i.e. scanning must go on
+ */
+bool matrix_kbd_debounce_update(matrix_kbd_debounce_t *debounce, const uint32_t *raw_rows, matrix_kbd_debounce_edge_cb_t on_edge, void *user_ctx);
+
+/**
+ * @brief Get the debounced state of the matrix
+ *
+ * @param[in] debounce Debouncer returned from `matrix_kbd_debounce_new`
+ * @return Array of `nr_rows` bitmaps, bit N of entry M is set if the key at row M, column N is pressed
+ */
+const uint32_t *matrix_kbd_debounce_get_state(const matrix_kbd_debounce_t *debounce);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,103 @@
+/*
+ * SPDX-FileCopyrightText: 2020-2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "matrix_keyboard.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Type of gesture engine
+ *
+ * @note Every key runs a small state machine driven by a `const` transition table, fed with debounced edges.
+ *       All timeouts (long press, repeat, double tap window, chord window) live in one hashed timer wheel shared by the
+ *       whole matrix, so a tick only visits the timers expiring in the current slot, never the idle keys.
+ */
+typedef struct matrix_kbd_gesture_t matrix_kbd_gesture_t;
+
+/**
+ * @brief Gesture timing, in milliseconds, 0 disables the gesture
+ */
+typedef struct {
+    uint32_t long_press_ms;      /*!< Hold time before a long press */
+    uint32_t repeat_interval_ms; /*!< Period of repeats after a long press */
+    uint32_t double_tap_ms;      /*!< Max time between release and next press for a double tap */
+    uint32_t chord_window_ms;    /*!< Time in which all keys of a chord must be pressed */
+} matrix_kbd_gesture_config_t;
+
+/**
+ * @brief Callback invoked for each gesture
+ *
+ * @param[in] id Gesture event, one of `MATRIX_KBD_EVENT_LONG_PRESS`, `_REPEAT`, `_DOUBLE_TAP` or `_CHORD`
+ * @param[in] key_codes Key code of the key, or of all keys of the chord in press order
+ * @param[in] nr_keys Number of entries in `key_codes`, more than one only for `MATRIX_KBD_EVENT_CHORD`
+ * @param[in] user_ctx User context passed to `matrix_kbd_gesture_on_key` or `matrix_kbd_gesture_tick`
+ */
+typedef void (*matrix_kbd_gesture_cb_t)(matrix_kbd_event_id_t id, const uint32_t *key_codes, uint32_t nr_keys, void *user_ctx);
+
+/**
+ * @brief Create a gesture engine for a matrix
+ *
+ * @param[in] nr_rows Number of rows
+ * @param[in] nr_cols Number of columns
+ * @param[in] config Gesture timing
+ * @param[out] ret_gesture Returned gesture engine
+ * @return
+ *      - ESP_OK: Create gesture engine successfully
+ *      - ESP_ERR_INVALID_ARG: Create gesture engine failed because of invalid argument
+ *      - ESP_ERR_NO_MEM: Create gesture engine failed because of out of memory
+ */
+esp_err_t matrix_kbd_gesture_new(uint32_t nr_rows, uint32_t nr_cols, const matrix_kbd_gesture_config_t *config, matrix_kbd_gesture_t **ret_gesture);
+
+/**
+ * @brief Delete a gesture engine
+ *
+ * @param[in] gesture Gesture engine returned from `matrix_kbd_gesture_new`
+ */
+void matrix_kbd_gesture_del(matrix_kbd_gesture_t *gesture);
+
+/**
+ * @brief Return every key to idle and drop all pending timers
+ *
+ * @param[in] gesture Gesture engine returned from `matrix_kbd_gesture_new`
+ * @param[in] now_ms Current time, in milliseconds
+ */
+void matrix_kbd_gesture_reset(matrix_kbd_gesture_t *gesture, uint32_t now_ms);
+
+/**
+ * @brief Feed a debounced key edge
+ *
+ * @note Timers which expired before `now_ms` are processed first, so the engine doesn't need to be ticked while idle.
+ *
+ * @param[in] gesture Gesture engine returned from `matrix_kbd_gesture_new`
+ * @param[in] row Row index of the key
+ * @param[in] col Column index of the key
+ * @param[in] pressed True if the key has been pressed, false if it has been released
+ * @param[in] now_ms Time of the edge, in milliseconds
+ * @param[in] on_gesture Callback invoked for each gesture
+ * @param[in] user_ctx User context passed to `on_gesture`
+ */
+void matrix_kbd_gesture_on_key(matrix_kbd_gesture_t *gesture, uint32_t row, uint32_t col, bool pressed, uint32_t now_ms,
+                               matrix_kbd_gesture_cb_t on_gesture, void *user_ctx);
+
+/**
+ * @brief Advance the timer wheel to `now_ms` and run the expired timers
+ *
+ * @param[in] gesture Gesture engine returned from `matrix_kbd_gesture_new`
+ * @param[in] now_ms Current time, in milliseconds
+ * @param[in] on_gesture Callback invoked for each gesture
+ * @param[in] user_ctx User context passed to `on_gesture`
+ */
+void matrix_kbd_gesture_tick(matrix_kbd_gesture_t *gesture, uint32_t now_ms, matrix_kbd_gesture_cb_t on_gesture, void *user_ctx);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,41 @@
+/*
+ * SPDX-FileCopyrightText: 2020-2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Find the keys which can't be told apart from a ghost in a matrix without diodes
+ *
+ * @note Without diodes, three pressed corners of a rectangle connect the fourth one, which then reads pressed too.
+ *       Any two rows sharing two or more pressed columns form such a rectangle, and none of its corners can be trusted.
+ *       The cost only depends on the number of rows, one AND per pair of rows, never on which keys are pressed.
+ *
+ * @param[in] raw_rows Array of `nr_rows` bitmaps, bit N of entry M is set if the key at row M, column N reads pressed
+ * @param[in] nr_rows Number of rows
+ * @param[out] ambiguous_rows Array of `nr_rows` bitmaps, returns the keys which are a corner of a rectangle
+ * @return True if any key is ambiguous
+ */
+bool matrix_kbd_ghost_detect(const uint32_t *raw_rows, uint32_t nr_rows, uint32_t *ambiguous_rows);
+
+/**
+ * @brief Keep the ambiguous keys in their previous debounced state
+ *
+ * @param[in,out] raw_rows Array of `nr_rows` bitmaps, ambiguous bits are replaced by the matching bit of `stable_rows`
+ * @param[in] stable_rows Debounced state, refer to `matrix_kbd_debounce_get_state`
+ * @param[in] ambiguous_rows Keys returned from `matrix_kbd_ghost_detect`
+ * @param[in] nr_rows Number of rows
+ */
+void matrix_kbd_ghost_block(uint32_t *raw_rows, const uint32_t *stable_rows, const uint32_t *ambiguous_rows, uint32_t nr_rows);
+
+#ifdef __cplusplus
+}
+#endif
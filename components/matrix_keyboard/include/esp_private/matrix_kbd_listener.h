@@ -0,0 +1,78 @@
+/*
+ * SPDX-FileCopyrightText: 2020-2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "matrix_keyboard.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Event handler, and the events it receives
+ */
+typedef struct {
+    uint32_t event_mask;                /*!< OR of `MATRIX_KBD_EVENT_MASK(id)`, 0 for a free slot */
+    matrix_kbd_event_handler handler;   /*!< Event handler, NULL for a free slot */
+    void *args;                         /*!< Argument passed to the handler */
+} matrix_kbd_listener_t;
+
+/**
+ * @brief Listener slots of a matrix keyboard
+ *
+ * @note The table itself isn't locked, the caller serializes the updates against the readers.
+ */
+typedef struct {
+    volatile uint32_t mask;                                     /*!< Union of all event masks, events outside are never queued */
+    matrix_kbd_listener_t slots[MATRIX_KBD_MAX_LISTENERS + 1];  /*!< slots[0] is the handler set by `matrix_kbd_register_event_handler` */
+} matrix_kbd_listeners_t;
+
+/**
+ * @brief Set one listener slot, and recompute the union of all event masks
+ *
+ * @param[in] listeners Listener slots
+ * @param[in] index Slot to set, 0 to `MATRIX_KBD_MAX_LISTENERS`
+ * @param[in] event_mask Events to receive, ignored if `handler` is NULL
+ * @param[in] handler Event handler, NULL frees the slot
+ * @param[in] args Argument passed to the handler
+ */
+void matrix_kbd_listeners_set(matrix_kbd_listeners_t *listeners, int index, uint32_t event_mask, matrix_kbd_event_handler handler, void *args);
+
+/**
+ * @brief Put a listener in the first free slot after slot 0
+ *
+ * @return Index of the slot, or 0 if all `MATRIX_KBD_MAX_LISTENERS` slots are taken
+ */
+int matrix_kbd_listeners_add(matrix_kbd_listeners_t *listeners, uint32_t event_mask, matrix_kbd_event_handler handler, void *args);
+
+/**
+ * @brief Free the first slot after slot 0 which holds this handler and argument
+ *
+ * @return Index of the freed slot, or 0 if no slot matched
+ */
+int matrix_kbd_listeners_remove(matrix_kbd_listeners_t *listeners, matrix_kbd_event_handler handler, void *args);
+
+/**
+ * @brief Check whether any listener receives an event
+ */
+static inline bool matrix_kbd_listeners_want(const matrix_kbd_listeners_t *listeners, matrix_kbd_event_id_t id)
+{
+    return listeners->mask & MATRIX_KBD_EVENT_MASK(id);
+}
+
+/**
+ * @brief Check whether one listener receives an event
+ */
+static inline bool matrix_kbd_listener_wants(const matrix_kbd_listener_t *listener, matrix_kbd_event_id_t id)
+{
+    return listener->handler && (listener->event_mask & MATRIX_KBD_EVENT_MASK(id));
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,57 @@
+/*
+ * SPDX-FileCopyrightText: 2020-2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdatomic.h>
+#include "matrix_keyboard.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Single writer snapshot, published with a sequence lock over two copies
+ *
+ * @note The writer bumps `seq` before rewriting each copy, readers copy out `copies[seq & 1]`, which is never the one
+ *       being written, and retry if `seq` moved meanwhile. A reader preempting the writer therefore never spins,
+ *       and the writer never waits for readers.
+ */
+typedef struct {
+    atomic_uint_fast32_t seq;            /*!< Odd while copies[0] is written, even while copies[1] is written */
+    matrix_kbd_snapshot_t copies[2];     /*!< Two copies of the snapshot */
+} matrix_kbd_latch_t;
+
+static inline void matrix_kbd_latch_init(matrix_kbd_latch_t *latch)
+{
+    atomic_init(&latch->seq, 0);
+}
+
+static inline void matrix_kbd_latch_publish(matrix_kbd_latch_t *latch, const matrix_kbd_snapshot_t *snapshot)
+{
+    uint32_t seq = atomic_load_explicit(&latch->seq, memory_order_relaxed);
+    for (int i = 0; i < 2; i++) {
+        // move readers to the other copy before this one is overwritten
+        atomic_store_explicit(&latch->seq, ++seq, memory_order_relaxed);
+        atomic_thread_fence(memory_order_release);
+        latch->copies[i] = *snapshot;
+    }
+}
+
+static inline void matrix_kbd_latch_read(matrix_kbd_latch_t *latch, matrix_kbd_snapshot_t *snapshot)
+{
+    uint32_t seq;
+    do {
+        seq = atomic_load_explicit(&latch->seq, memory_order_acquire);
+        *snapshot = latch->copies[seq & 1];
+        // the copy must be complete before `seq` is checked again
+        atomic_thread_fence(memory_order_acquire);
+    } while (atomic_load_explicit(&latch->seq, memory_order_relaxed) != seq);
+}
+
+#ifdef __cplusplus
+}
+#endif
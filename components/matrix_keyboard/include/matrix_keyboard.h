@@ -15,6 +15,7 @@
 #pragma once
 
 #include <stdint.h>
+#include <stdbool.h>
 #include "esp_err.h"
 
 #ifdef __cplusplus
@@ -25,6 +26,13 @@ extern "C" {
 #define GET_KEY_CODE_ROW(code)  ((code >> 8) & 0xFF)
 #define GET_KEY_CODE_COL(code)  (code & 0xFF)
 
+#define MATRIX_KBD_CHORD_MAX_KEYS 4 /*!< Maximum number of keys in a chord, no chord is reported when more keys are pressed in the window */
+#define MATRIX_KBD_MAX_KEYS       256 /*!< Maximum number of keys in the matrix, `nr_row_gpios * nr_col_gpios` */
+#define MATRIX_KBD_MAX_LISTENERS  4 /*!< Maximum number of listeners added with `matrix_kbd_add_listener` */
+
+#define MATRIX_KBD_EVENT_MASK(id)  (1U << (id)) /*!< Bit of event `id` in a listener event mask */
+#define MATRIX_KBD_EVENT_MASK_ALL  0xFFFFFFFF   /*!< Event mask of a listener interested in every event */
+
 /**
  * @brief Type defined for matrix keyboard handle
  *
@@ -36,19 +44,92 @@ typedef struct matrix_kbd_t *matrix_kbd_handle_t;
  *
  */
 typedef enum {
-    MATRIX_KBD_EVENT_DOWN, /*!< Key is pressed down */
-    MATRIX_KBD_EVENT_UP    /*!< Key is released */
+    MATRIX_KBD_EVENT_DOWN,       /*!< Key is pressed down */
+    MATRIX_KBD_EVENT_UP,         /*!< Key is released */
+    MATRIX_KBD_EVENT_LONG_PRESS, /*!< Key has been held for `long_press_ms` */
+    MATRIX_KBD_EVENT_REPEAT,     /*!< Key is still held, sent every `repeat_interval_ms` after the long press */
+    MATRIX_KBD_EVENT_DOUBLE_TAP, /*!< Key is pressed again within `double_tap_ms` of being released */
+    MATRIX_KBD_EVENT_CHORD,      /*!< 2 to `MATRIX_KBD_CHORD_MAX_KEYS` keys were pressed within `chord_window_ms` and are all still held */
 } matrix_kbd_event_id_t;
 
+/**
+ * @brief Matrix keyboard scan mode
+ *
+ */
+typedef enum {
+    MATRIX_KBD_SCAN_MODE_INTERRUPT, /*!< Sleep on a row edge interrupt, scan only while any key is pressed or settling */
+    MATRIX_KBD_SCAN_MODE_PERIODIC,  /*!< Scan the whole matrix on every tick, from start to stop, even when idle */
+} matrix_kbd_scan_mode_t;
+
+/**
+ * @brief How to handle keys which may be ghosts
+ *
+ * @note In a matrix without diodes, pressing three corners of a rectangle makes the fourth corner read pressed too.
+ *       The driver flags every corner of such a rectangle as ambiguous, since it can't tell which one is the ghost.
+ */
+typedef enum {
+    MATRIX_KBD_GHOST_BLOCK, /*!< Ambiguous keys keep their previous state until the rectangle is broken */
+    MATRIX_KBD_GHOST_FLAG,  /*!< Ambiguous keys are reported, their events have `ambiguous` set */
+    MATRIX_KBD_GHOST_OFF,   /*!< No detection, for matrices with a diode on every key */
+} matrix_kbd_ghost_mode_t;
+
+/**
+ * @brief Statistics of the scan tick
+ *
+ */
+typedef struct {
+    uint32_t nr_scans;           /*!< Number of scans since the driver was started */
+    uint32_t max_scan_cycles;    /*!< Longest scan, from sampling the first row to posting the last event, in CPU cycles */
+    uint64_t total_scan_cycles;  /*!< Sum of all scans, in CPU cycles, divide by `nr_scans` for the average */
+    uint32_t nr_ghost_scans;     /*!< Number of scans which found ambiguous keys */
+} matrix_kbd_scan_stats_t;
+
+/**
+ * @brief Data passed to the event handler along with the event ID
+ *
+ */
+typedef struct {
+    uint32_t key_code;    /*!< Key code of the key which changed, use `GET_KEY_CODE_ROW` and `GET_KEY_CODE_COL` to decode */
+    int64_t timestamp_us; /*!< Time at which the change was detected, in microseconds since boot (`esp_timer_get_time`) */
+    int64_t edge_time_us; /*!< Time of the row edge interrupt which woke the scan, set on the first key down after idle in
+                               `MATRIX_KBD_SCAN_MODE_INTERRUPT` mode, 0 when no edge was captured for this event */
+    bool woke_up;         /*!< The edge in `edge_time_us` woke the chip up from light sleep, needs `light_sleep_wakeup` and
+                               `CONFIG_PM_LIGHT_SLEEP_CALLBACKS`, never set otherwise */
+    bool ambiguous;         /*!< Key was a corner of a ghost rectangle when the event was detected, refer to `MATRIX_KBD_GHOST_FLAG` */
+    uint32_t nr_chord_keys; /*!< Number of keys in `chord_key_codes`, only set for `MATRIX_KBD_EVENT_CHORD` */
+    uint32_t chord_key_codes[MATRIX_KBD_CHORD_MAX_KEYS]; /*!< Key codes of the chord in press order, `key_code` is the first one */
+} matrix_kbd_event_data_t;
+
+/**
+ * @brief Snapshot of the debounced state of the whole matrix
+ *
+ */
+typedef struct {
+    uint32_t seq;                               /*!< Sequence number of the scan, increases by one with every scan and never
+                                                     goes back, equal numbers mean nothing was scanned in between */
+    int64_t scan_time_us;                       /*!< Time of the scan, in microseconds since boot */
+    uint32_t keys[MATRIX_KBD_MAX_KEYS / 32];    /*!< Packed bitmap of all keys, bit `row * nr_col_gpios + col` is set if the key
+                                                     is pressed, refer to `MATRIX_KBD_SNAPSHOT_KEY_PRESSED` */
+} matrix_kbd_snapshot_t;
+
+/**
+ * @brief Check a key in a `matrix_kbd_snapshot_t`
+ *
+ */
+#define MATRIX_KBD_SNAPSHOT_KEY_PRESSED(snapshot, nr_cols, row, col) \
+    (((snapshot)->keys[((row) * (nr_cols) + (col)) / 32] >> (((row) * (nr_cols) + (col)) % 32)) & 1)
+
 /**
  * @brief Type defined for matrix keyboard event handler
  *
- * @note The event handler runs in a OS timer context
+ * @note The event handler runs in the matrix keyboard dispatch task, so it's allowed to block.
+ *       While it blocks, new events are buffered in the event queue and dropped once the queue is full.
+ *       Listeners are called one after another, in the order they were added.
  *
  * @param[in] mkbd_handle Handle of matrix keyboard that return from `matrix_kbd_install`
  * @param[in] event Event ID, refer to `matrix_kbd_event_id_t` to see all supported events
- * @param[in] event_data Data for corresponding event
- * @param[in] handler_args Arguments that user passed in from `matrix_kbd_register_event_handler`
+ * @param[in] event_data Pointer to `matrix_kbd_event_data_t`, only valid until the handler returns
+ * @param[in] handler_args Arguments that user passed in from `matrix_kbd_register_event_handler` or `matrix_kbd_add_listener`
  * @return Currently always return ESP_OK
  */
 typedef esp_err_t (*matrix_kbd_event_handler)(matrix_kbd_handle_t mkbd_handle, matrix_kbd_event_id_t event, void *event_data, void *handler_args);
@@ -58,24 +139,46 @@ typedef esp_err_t (*matrix_kbd_event_handler)(matrix_kbd_handle_t mkbd_handle, m
  *
  */
 typedef struct {
-    const int *row_gpios;  /*!< Array, contains GPIO numbers used by row line */
-    const int *col_gpios;  /*!< Array, contains GPIO numbers used by column line */
-    uint32_t nr_row_gpios; /*!< row_gpios array size */
-    uint32_t nr_col_gpios; /*!< col_gpios array size */
-    uint32_t debounce_ms;  /*!< Debounce time */
+    const int *row_gpios;               /*!< Array, contains GPIO numbers used by row line */
+    const int *col_gpios;               /*!< Array, contains GPIO numbers used by column line */
+    uint32_t nr_row_gpios;              /*!< row_gpios array size */
+    uint32_t nr_col_gpios;              /*!< col_gpios array size */
+    uint32_t debounce_ms;               /*!< Debounce time, each key must read the same level for this long before its state changes */
+    matrix_kbd_scan_mode_t scan_mode;   /*!< Scan mode, refer to `matrix_kbd_scan_mode_t` */
+    matrix_kbd_ghost_mode_t ghost_mode; /*!< How to handle keys which may be ghosts, refer to `matrix_kbd_ghost_mode_t` */
+    bool light_sleep_wakeup;            /*!< Arm the row lines as GPIO wake-up sources, so the system can enter light sleep while no key is pressed */
+    uint32_t scan_interval_us;          /*!< Period of the scan tick which samples the whole matrix, 200~1000 gives a 1~5 kHz scan rate */
+    uint32_t long_press_ms;             /*!< Hold time before `MATRIX_KBD_EVENT_LONG_PRESS`, 0 disables long press and repeat */
+    uint32_t repeat_interval_ms;        /*!< Period of `MATRIX_KBD_EVENT_REPEAT` after the long press, 0 disables repeat */
+    uint32_t double_tap_ms;             /*!< Max time between release and next press for `MATRIX_KBD_EVENT_DOUBLE_TAP`, 0 disables it */
+    uint32_t chord_window_ms;           /*!< Time in which all keys of a chord must be pressed, 0 disables `MATRIX_KBD_EVENT_CHORD` */
+    uint32_t event_queue_size;          /*!< Number of events buffered between detection and dispatch, must be a power of two */
+    uint32_t task_priority;             /*!< Priority of the dispatch task which runs the event handler */
+    uint32_t task_stack_size;           /*!< Stack size of the dispatch task, in bytes */
 } matrix_kbd_config_t;
 
 /**
  * @brief Default configuration for matrix keyboard driver
  *
  */
-#define MATRIX_KEYBOARD_DEFAULT_CONFIG() \
-{                                        \
-    .row_gpios = NULL,                   \
-    .col_gpios = NULL,                   \
-    .nr_row_gpios = 0,                   \
-    .nr_col_gpios = 0,                   \
-    .debounce_ms = 20,                   \
+#define MATRIX_KEYBOARD_DEFAULT_CONFIG()         \
+{                                                \
+    .row_gpios = NULL,                           \
+    .col_gpios = NULL,                           \
+    .nr_row_gpios = 0,                           \
+    .nr_col_gpios = 0,                           \
+    .debounce_ms = 5,                            \
+    .scan_mode = MATRIX_KBD_SCAN_MODE_INTERRUPT, \
+    .ghost_mode = MATRIX_KBD_GHOST_BLOCK,        \
+    .light_sleep_wakeup = false,                 \
+    .scan_interval_us = 1000,                    \
+    .long_press_ms = 0,                          \
+    .repeat_interval_ms = 0,                     \
+    .double_tap_ms = 0,                          \
+    .chord_window_ms = 0,                        \
+    .event_queue_size = 16,                      \
+    .task_priority = 10,                         \
+    .task_stack_size = 3072,                     \
 }
 
 /**
@@ -127,6 +230,9 @@ esp_err_t matrix_kbd_stop(matrix_kbd_handle_t mkbd_handle);
 /**
  * @brief Register matrix keyboard event handler
  *
+ * @note The handler receives every event. It replaces the handler set by the previous call, NULL removes it.
+ *       Listeners added with `matrix_kbd_add_listener` are not affected.
+ *
  * @param[in] mkbd_handle Handle of matrix keyboard that return from `matrix_kbd_install`
  * @param[in] handler Event handler
  * @param[in] args Arguments that will be passed to the handler
@@ -137,6 +243,76 @@ esp_err_t matrix_kbd_stop(matrix_kbd_handle_t mkbd_handle);
  */
 esp_err_t matrix_kbd_register_event_handler(matrix_kbd_handle_t mkbd_handle, matrix_kbd_event_handler handler, void *args);
 
+/**
+ * @brief Add a listener of a subset of events
+ *
+ * @note Events no listener is interested in are dropped by the scan tick, they never reach the event queue.
+ *
+ * @param[in] mkbd_handle Handle of matrix keyboard that return from `matrix_kbd_install`
+ * @param[in] event_mask Events to receive, OR of `MATRIX_KBD_EVENT_MASK(id)`, or `MATRIX_KBD_EVENT_MASK_ALL`
+ * @param[in] handler Event handler
+ * @param[in] args Arguments that will be passed to the handler
+ * @return
+ *      - ESP_OK: Add listener successfully
+ *      - ESP_ERR_INVALID_ARG: Add listener failed because of some invalid argument
+ *      - ESP_ERR_NO_MEM: Add listener failed because `MATRIX_KBD_MAX_LISTENERS` are already added
+ */
+esp_err_t matrix_kbd_add_listener(matrix_kbd_handle_t mkbd_handle, uint32_t event_mask, matrix_kbd_event_handler handler, void *args);
+
+/**
+ * @brief Remove a listener added with `matrix_kbd_add_listener`
+ *
+ * @note The dispatch task may still be running the handler when this returns, don't free `args` from another task
+ *       before the handler is known to be done.
+ *
+ * @param[in] mkbd_handle Handle of matrix keyboard that return from `matrix_kbd_install`
+ * @param[in] handler Event handler passed to `matrix_kbd_add_listener`
+ * @param[in] args Arguments passed to `matrix_kbd_add_listener`
+ * @return
+ *      - ESP_OK: Remove listener successfully
+ *      - ESP_ERR_INVALID_ARG: Remove listener failed because of some invalid argument
+ *      - ESP_ERR_NOT_FOUND: Remove listener failed because no listener has this handler and arguments
+ */
+esp_err_t matrix_kbd_remove_listener(matrix_kbd_handle_t mkbd_handle, matrix_kbd_event_handler handler, void *args);
+
+/**
+ * @brief Get the number of events dropped because the event queue was full
+ *
+ * @param[in] mkbd_handle Handle of matrix keyboard that return from `matrix_kbd_install`
+ * @param[out] dropped Number of events dropped since the driver was installed
+ * @return
+ *      - ESP_OK: Get dropped event count successfully
+ *      - ESP_ERR_INVALID_ARG: Get dropped event count failed because of some invalid argument
+ */
+esp_err_t matrix_kbd_get_dropped_events(matrix_kbd_handle_t mkbd_handle, uint32_t *dropped);
+
+/**
+ * @brief Get a snapshot of the debounced state of the whole matrix
+ *
+ * @note The snapshot is published at the end of every scan, all keys come from the same scan. It never blocks the
+ *       scan tick nor the caller: a reader retries whenever a scan publishes while it is copying, a single publish is
+ *       enough, and copies again from the new snapshot. In `MATRIX_KBD_SCAN_MODE_PERIODIC` mode the snapshot
+ *       is at most `scan_interval_us` old, compare `seq` with the previous one to skip unchanged polls.
+ *
+ * @param[in] mkbd_handle Handle of matrix keyboard that return from `matrix_kbd_install`
+ * @param[out] snapshot Returned snapshot
+ * @return
+ *      - ESP_OK: Get snapshot successfully
+ *      - ESP_ERR_INVALID_ARG: Get snapshot failed because of some invalid argument
+ */
+esp_err_t matrix_kbd_get_snapshot(matrix_kbd_handle_t mkbd_handle, matrix_kbd_snapshot_t *snapshot);
+
+/**
+ * @brief Get statistics of the scan tick, used to measure the polling overhead
+ *
+ * @param[in] mkbd_handle Handle of matrix keyboard that return from `matrix_kbd_install`
+ * @param[out] stats Returned scan statistics, reset on every `matrix_kbd_start`
+ * @return
+ *      - ESP_OK: Get scan statistics successfully
+ *      - ESP_ERR_INVALID_ARG: Get scan statistics failed because of some invalid argument
+ */
+esp_err_t matrix_kbd_get_scan_stats(matrix_kbd_handle_t mkbd_handle, matrix_kbd_scan_stats_t *stats);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,159 @@
+/*
+ * SPDX-FileCopyrightText: 2020-2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "esp_private/matrix_kbd_core.h"
+#include "esp_private/matrix_kbd_debounce.h"
+#include "esp_private/matrix_kbd_ghost.h"
+
+struct matrix_kbd_core_t {
+    uint32_t nr_rows;
+    uint32_t nr_cols;
+    matrix_kbd_ghost_mode_t ghost_mode;
+    matrix_kbd_debounce_t *debounce;
+    matrix_kbd_gesture_t *gesture;
+    matrix_kbd_core_event_cb_t on_event;
+    void *user_ctx;
+    int64_t scan_time_us;       // time of the scan being processed
+    int64_t *edge_time_us;      // edge of the scan being processed, consumed by the first key down
+    uint32_t nr_ghost_scans;
+    uint32_t ambiguous_rows[];  // ambiguous keys of the scan being processed
+};
+
+static void matrix_kbd_core_on_gesture(matrix_kbd_event_id_t id, const uint32_t *key_codes, uint32_t nr_keys, void *user_ctx)
+{
+    matrix_kbd_core_t *core = (matrix_kbd_core_t *)user_ctx;
+    matrix_kbd_event_data_t data = {
+        .key_code = key_codes[0],
+        .timestamp_us = core->scan_time_us,
+    };
+    if (id == MATRIX_KBD_EVENT_CHORD) {
+        data.nr_chord_keys = nr_keys;
+        for (uint32_t i = 0; i < nr_keys; i++) {
+            data.chord_key_codes[i] = key_codes[i];
+        }
+    }
+    core->on_event(id, &data, core->user_ctx);
+}
+
+static void matrix_kbd_core_on_edge(uint32_t row, uint32_t col, bool pressed, void *user_ctx)
+{
+    matrix_kbd_core_t *core = (matrix_kbd_core_t *)user_ctx;
+    matrix_kbd_event_data_t data = {
+        .key_code = MAKE_KEY_CODE(row, col),
+        .timestamp_us = core->scan_time_us,
+        .ambiguous = (core->ambiguous_rows[row] >> col) & 1,
+    };
+    // the edge belongs to the key press which woke the scan, hand it to the first key down only
+    if (pressed && core->edge_time_us) {
+        data.edge_time_us = *core->edge_time_us;
+        *core->edge_time_us = 0;
+    }
+    core->on_event(pressed ? MATRIX_KBD_EVENT_DOWN : MATRIX_KBD_EVENT_UP, &data, core->user_ctx);
+    if (core->gesture) {
+        matrix_kbd_gesture_on_key(core->gesture, row, col, pressed, core->scan_time_us / 1000, matrix_kbd_core_on_gesture, core);
+    }
+}
+
+esp_err_t matrix_kbd_core_new(const matrix_kbd_core_config_t *config, matrix_kbd_core_event_cb_t on_event, void *user_ctx, matrix_kbd_core_t **ret_core)
+{
+    esp_err_t ret = ESP_OK;
+    if (!config || !on_event || !ret_core || config->ghost_mode > MATRIX_KBD_GHOST_OFF) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    matrix_kbd_core_t *core = calloc(1, sizeof(matrix_kbd_core_t) + config->nr_rows * sizeof(uint32_t));
+    if (!core) {
+        return ESP_ERR_NO_MEM;
+    }
+    core->nr_rows = config->nr_rows;
+    core->nr_cols = config->nr_cols;
+    core->ghost_mode = config->ghost_mode;
+    core->on_event = on_event;
+    core->user_ctx = user_ctx;
+    ret = matrix_kbd_debounce_new(config->nr_rows, config->nr_cols, config->debounce_threshold, &core->debounce);
+    if (ret != ESP_OK) {
+        goto err;
+    }
+    // gestures are timed by one timer wheel for the whole matrix, only created if any gesture is enabled
+    if (config->gesture.long_press_ms || config->gesture.double_tap_ms || config->gesture.chord_window_ms) {
+        ret = matrix_kbd_gesture_new(config->nr_rows, config->nr_cols, &config->gesture, &core->gesture);
+        if (ret != ESP_OK) {
+            goto err;
+        }
+    }
+    *ret_core = core;
+    return ESP_OK;
+err:
+    matrix_kbd_core_del(core);
+    return ret;
+}
+
+void matrix_kbd_core_del(matrix_kbd_core_t *core)
+{
+    if (core->gesture) {
+        matrix_kbd_gesture_del(core->gesture);
+    }
+    if (core->debounce) {
+        matrix_kbd_debounce_del(core->debounce);
+    }
+    free(core);
+}
+
+void matrix_kbd_core_reset(matrix_kbd_core_t *core, int64_t now_us)
+{
+    matrix_kbd_debounce_reset(core->debounce);
+    if (core->gesture) {
+        matrix_kbd_gesture_reset(core->gesture, now_us / 1000);
+    }
+    for (uint32_t row = 0; row < core->nr_rows; row++) {
+        core->ambiguous_rows[row] = 0;
+    }
+    core->nr_ghost_scans = 0;
+}
+
+bool matrix_kbd_core_scan(matrix_kbd_core_t *core, uint32_t *raw_rows, int64_t scan_time_us, int64_t *edge_time_us)
+{
+    core->scan_time_us = scan_time_us;
+    core->edge_time_us = edge_time_us;
+    if (core->ghost_mode != MATRIX_KBD_GHOST_OFF && matrix_kbd_ghost_detect(raw_rows, core->nr_rows, core->ambiguous_rows)) {
+        core->nr_ghost_scans++;
+        if (core->ghost_mode == MATRIX_KBD_GHOST_BLOCK) {
+            matrix_kbd_ghost_block(raw_rows, matrix_kbd_debounce_get_state(core->debounce), core->ambiguous_rows, core->nr_rows);
+        }
+    }
+    bool busy = matrix_kbd_debounce_update(core->debounce, raw_rows, matrix_kbd_core_on_edge, core);
+    if (core->gesture) {
+        // gesture timers of released keys simply expire on the next edge, only held keys need the scan to go on
+        matrix_kbd_gesture_tick(core->gesture, scan_time_us / 1000, matrix_kbd_core_on_gesture, core);
+    }
+    core->edge_time_us = NULL;
+    return busy;
+}
+
+const uint32_t *matrix_kbd_core_get_state(const matrix_kbd_core_t *core)
+{
+    return matrix_kbd_debounce_get_state(core->debounce);
+}
+
+void matrix_kbd_core_pack_state(const matrix_kbd_core_t *core, uint32_t *keys)
+{
+    const uint32_t *state = matrix_kbd_debounce_get_state(core->debounce);
+    memset(keys, 0, (core->nr_rows * core->nr_cols + 31) / 32 * sizeof(uint32_t));
+    for (uint32_t row = 0; row < core->nr_rows; row++) {
+        uint32_t bit = row * core->nr_cols;
+        uint32_t shift = bit % 32;
+        keys[bit / 32] |= state[row] << shift;
+        // the row straddles two words
+        if (shift + core->nr_cols > 32) {
+            keys[bit / 32 + 1] |= state[row] >> (32 - shift);
+        }
+    }
+}
+
+uint32_t matrix_kbd_core_get_ghost_scans(const matrix_kbd_core_t *core)
+{
+    return core->nr_ghost_scans;
+}
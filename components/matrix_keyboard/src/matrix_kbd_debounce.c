@@ -0,0 +1,110 @@
+/*
+ * SPDX-FileCopyrightText: 2020-2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <stdlib.h>
+#include "esp_private/matrix_kbd_debounce.h"
+
+struct matrix_kbd_debounce_t {
+    uint32_t nr_rows;
+    uint32_t nr_cols;
+    uint8_t threshold;
+    uint32_t *stable;     // debounced state, one bitmap per row
+    uint32_t *unsettled;  // keys whose integrator is neither 0 nor threshold, one bitmap per row
+    uint8_t *integrator;  // one integrator per key, indexed by row * nr_cols + col
+    uint32_t storage[];
+};
+
+esp_err_t matrix_kbd_debounce_new(uint32_t nr_rows, uint32_t nr_cols, uint32_t threshold, matrix_kbd_debounce_t **ret_debounce)
+{
+    if (!ret_debounce || !nr_rows || !nr_cols || nr_cols > 32 || !threshold || threshold > UINT8_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    // row bitmaps first so they stay word aligned, integrators at the end
+    matrix_kbd_debounce_t *debounce = calloc(1, sizeof(matrix_kbd_debounce_t) + 2 * nr_rows * sizeof(uint32_t) + nr_rows * nr_cols);
+    if (!debounce) {
+        return ESP_ERR_NO_MEM;
+    }
+    debounce->nr_rows = nr_rows;
+    debounce->nr_cols = nr_cols;
+    debounce->threshold = threshold;
+    debounce->stable = debounce->storage;
+    debounce->unsettled = debounce->storage + nr_rows;
+    debounce->integrator = (uint8_t *)(debounce->storage + 2 * nr_rows);
+    *ret_debounce = debounce;
+    return ESP_OK;
+}
+
+void matrix_kbd_debounce_del(matrix_kbd_debounce_t *debounce)
+{
+    free(debounce);
+}
+
+void matrix_kbd_debounce_reset(matrix_kbd_debounce_t *debounce)
+{
+    for (uint32_t row = 0; row < debounce->nr_rows; row++) {
+        debounce->stable[row] = 0;
+        debounce->unsettled[row] = 0;
+    }
+    for (uint32_t i = 0; i < debounce->nr_rows * debounce->nr_cols; i++) {
+        debounce->integrator[i] = 0;
+    }
+}
+
+bool matrix_kbd_debounce_update(matrix_kbd_debounce_t *debounce, const uint32_t *raw_rows, matrix_kbd_debounce_edge_cb_t on_edge, void *user_ctx)
+{
+    uint32_t col_mask = debounce->nr_cols == 32 ? UINT32_MAX : (1UL << debounce->nr_cols) - 1;
+    uint8_t threshold = debounce->threshold;
+    bool busy = false;
+    for (uint32_t row = 0; row < debounce->nr_rows; row++) {
+        uint32_t raw = raw_rows[row] & col_mask;
+        uint32_t stable = debounce->stable[row];
+        uint32_t unsettled = debounce->unsettled[row];
+        // keys agreeing with their debounced state and sitting at a saturated integrator cost nothing
+        uint32_t work = (raw ^ stable) | unsettled;
+        uint8_t *integrator = &debounce->integrator[row * debounce->nr_cols];
+        while (work) {
+            uint32_t col = __builtin_ctz(work);
+            uint32_t bit = 1UL << col;
+            uint8_t count = integrator[col];
+            if (raw & bit) {
+                if (count < threshold) {
+                    count++;
+                }
+                if (count == threshold && !(stable & bit)) {
+                    stable |= bit;
+                    if (on_edge) {
+                        on_edge(row, col, true, user_ctx);
+                    }
+                }
+            } else {
+                if (count > 0) {
+                    count--;
+                }
+                if (count == 0 && (stable & bit)) {
+                    stable &= ~bit;
+                    if (on_edge) {
+                        on_edge(row, col, false, user_ctx);
+                    }
+                }
+            }
+            integrator[col] = count;
+            if (count == ((stable & bit) ? threshold : 0)) {
+                unsettled &= ~bit;
+            } else {
+                unsettled |= bit;
+            }
+            work &= work - 1;
+        }
+        debounce->stable[row] = stable;
+        debounce->unsettled[row] = unsettled;
+        busy |= (stable | unsettled) != 0;
+    }
+    return busy;
+}
+
+const uint32_t *matrix_kbd_debounce_get_state(const matrix_kbd_debounce_t *debounce)
+{
+    return debounce->stable;
+}
@@ -0,0 +1,283 @@
+/*
+ * SPDX-FileCopyrightText: 2020-2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <stdlib.h>
+#include "esp_private/matrix_kbd_gesture.h"
+
+// Timer wheel of 1 ms slots, timers further away than one revolution just stay in their slot until they expire
+#define MKBD_WHEEL_SLOTS 64
+#define MKBD_WHEEL_MASK  (MKBD_WHEEL_SLOTS - 1)
+#define MKBD_NODE_NONE   UINT16_MAX
+
+typedef enum {
+    GESTURE_STATE_IDLE,
+    GESTURE_STATE_PRESSED,  // down, waiting for the long press
+    GESTURE_STATE_HELD,     // long press sent, repeating
+    GESTURE_STATE_TAP_WAIT, // released after a short press, waiting for the second tap
+    GESTURE_STATE_TAPPED,   // down again after a double tap, only a long press may follow
+    GESTURE_STATE_MAX,
+} gesture_state_t;
+
+typedef enum {
+    GESTURE_INPUT_DOWN,
+    GESTURE_INPUT_UP,
+    GESTURE_INPUT_TIMEOUT,
+    GESTURE_INPUT_MAX,
+} gesture_input_t;
+
+typedef enum {
+    GESTURE_TIMER_KEEP,   // leave the pending timer untouched
+    GESTURE_TIMER_NONE,   // cancel the pending timer
+    GESTURE_TIMER_LONG,
+    GESTURE_TIMER_REPEAT,
+    GESTURE_TIMER_TAP,
+} gesture_timer_t;
+
+#define GESTURE_EMIT_NONE 0xFF
+
+typedef struct {
+    uint8_t next;            // state to enter
+    uint8_t emit;            // event to send, or GESTURE_EMIT_NONE
+    uint8_t timer;           // timer to arm on entering `next`
+    uint8_t next_if_off;     // state to enter instead when the timer's gesture is disabled
+} gesture_transition_t;
+
+static const gesture_transition_t s_transitions[GESTURE_STATE_MAX][GESTURE_INPUT_MAX] = {
+    [GESTURE_STATE_IDLE] = {
+        [GESTURE_INPUT_DOWN]    = {GESTURE_STATE_PRESSED, GESTURE_EMIT_NONE, GESTURE_TIMER_LONG, GESTURE_STATE_PRESSED},
+        [GESTURE_INPUT_UP]      = {GESTURE_STATE_IDLE, GESTURE_EMIT_NONE, GESTURE_TIMER_KEEP, GESTURE_STATE_IDLE},
+        [GESTURE_INPUT_TIMEOUT] = {GESTURE_STATE_IDLE, GESTURE_EMIT_NONE, GESTURE_TIMER_NONE, GESTURE_STATE_IDLE},
+    },
+    [GESTURE_STATE_PRESSED] = {
+        [GESTURE_INPUT_DOWN]    = {GESTURE_STATE_PRESSED, GESTURE_EMIT_NONE, GESTURE_TIMER_KEEP, GESTURE_STATE_PRESSED},
+        [GESTURE_INPUT_UP]      = {GESTURE_STATE_TAP_WAIT, GESTURE_EMIT_NONE, GESTURE_TIMER_TAP, GESTURE_STATE_IDLE},
+        [GESTURE_INPUT_TIMEOUT] = {GESTURE_STATE_HELD, MATRIX_KBD_EVENT_LONG_PRESS, GESTURE_TIMER_REPEAT, GESTURE_STATE_HELD},
+    },
+    [GESTURE_STATE_HELD] = {
+        [GESTURE_INPUT_DOWN]    = {GESTURE_STATE_HELD, GESTURE_EMIT_NONE, GESTURE_TIMER_KEEP, GESTURE_STATE_HELD},
+        [GESTURE_INPUT_UP]      = {GESTURE_STATE_IDLE, GESTURE_EMIT_NONE, GESTURE_TIMER_NONE, GESTURE_STATE_IDLE},
+        [GESTURE_INPUT_TIMEOUT] = {GESTURE_STATE_HELD, MATRIX_KBD_EVENT_REPEAT, GESTURE_TIMER_REPEAT, GESTURE_STATE_HELD},
+    },
+    [GESTURE_STATE_TAP_WAIT] = {
+        [GESTURE_INPUT_DOWN]    = {GESTURE_STATE_TAPPED, MATRIX_KBD_EVENT_DOUBLE_TAP, GESTURE_TIMER_LONG, GESTURE_STATE_TAPPED},
+        [GESTURE_INPUT_UP]      = {GESTURE_STATE_TAP_WAIT, GESTURE_EMIT_NONE, GESTURE_TIMER_KEEP, GESTURE_STATE_TAP_WAIT},
+        [GESTURE_INPUT_TIMEOUT] = {GESTURE_STATE_IDLE, GESTURE_EMIT_NONE, GESTURE_TIMER_NONE, GESTURE_STATE_IDLE},
+    },
+    [GESTURE_STATE_TAPPED] = {
+        [GESTURE_INPUT_DOWN]    = {GESTURE_STATE_TAPPED, GESTURE_EMIT_NONE, GESTURE_TIMER_KEEP, GESTURE_STATE_TAPPED},
+        [GESTURE_INPUT_UP]      = {GESTURE_STATE_IDLE, GESTURE_EMIT_NONE, GESTURE_TIMER_NONE, GESTURE_STATE_IDLE},
+        [GESTURE_INPUT_TIMEOUT] = {GESTURE_STATE_HELD, MATRIX_KBD_EVENT_LONG_PRESS, GESTURE_TIMER_REPEAT, GESTURE_STATE_HELD},
+    },
+};
+
+typedef struct {
+    uint32_t deadline_ms;
+    uint16_t next;        // next node in the same wheel slot
+    uint16_t prev;        // previous node in the same wheel slot, MKBD_NODE_NONE if the node is the slot head
+    uint8_t state;        // gesture_state_t, unused by the chord node
+    bool armed;
+} gesture_node_t;
+
+struct matrix_kbd_gesture_t {
+    uint32_t nr_cols;
+    uint32_t nr_keys;                 // node `nr_keys` is the chord window timer
+    uint32_t durations_ms[GESTURE_TIMER_TAP + 1];
+    uint32_t chord_window_ms;
+    uint32_t wheel_ms;                // last processed time
+    bool chord_open;
+    bool chord_overflow;              // more keys than MATRIX_KBD_CHORD_MAX_KEYS in the window, the chord is dropped
+    uint32_t nr_chord_keys;
+    uint32_t chord_key_codes[MATRIX_KBD_CHORD_MAX_KEYS];
+    uint16_t slots[MKBD_WHEEL_SLOTS];
+    gesture_node_t nodes[];
+};
+
+static inline bool time_reached(uint32_t deadline_ms, uint32_t now_ms)
+{
+    return (int32_t)(now_ms - deadline_ms) >= 0;
+}
+
+static void gesture_disarm(matrix_kbd_gesture_t *gesture, uint16_t index)
+{
+    gesture_node_t *node = &gesture->nodes[index];
+    if (!node->armed) {
+        return;
+    }
+    if (node->prev == MKBD_NODE_NONE) {
+        gesture->slots[node->deadline_ms & MKBD_WHEEL_MASK] = node->next;
+    } else {
+        gesture->nodes[node->prev].next = node->next;
+    }
+    if (node->next != MKBD_NODE_NONE) {
+        gesture->nodes[node->next].prev = node->prev;
+    }
+    node->armed = false;
+}
+
+static void gesture_arm(matrix_kbd_gesture_t *gesture, uint16_t index, uint32_t deadline_ms)
+{
+    gesture_disarm(gesture, index);
+    gesture_node_t *node = &gesture->nodes[index];
+    uint16_t *head = &gesture->slots[deadline_ms & MKBD_WHEEL_MASK];
+    node->deadline_ms = deadline_ms;
+    node->prev = MKBD_NODE_NONE;
+    node->next = *head;
+    if (*head != MKBD_NODE_NONE) {
+        gesture->nodes[*head].prev = index;
+    }
+    *head = index;
+    node->armed = true;
+}
+
+static uint32_t gesture_key_code(const matrix_kbd_gesture_t *gesture, uint32_t index)
+{
+    return MAKE_KEY_CODE(index / gesture->nr_cols, index % gesture->nr_cols);
+}
+
+static void gesture_run(matrix_kbd_gesture_t *gesture, uint16_t index, gesture_input_t input, uint32_t base_ms,
+                        matrix_kbd_gesture_cb_t on_gesture, void *user_ctx)
+{
+    gesture_node_t *node = &gesture->nodes[index];
+    const gesture_transition_t *t = &s_transitions[node->state][input];
+
+    if (t->emit != GESTURE_EMIT_NONE && on_gesture) {
+        uint32_t key_code = gesture_key_code(gesture, index);
+        on_gesture(t->emit, &key_code, 1, user_ctx);
+    }
+    if (t->timer == GESTURE_TIMER_KEEP) {
+        node->state = t->next;
+        return;
+    }
+    gesture_disarm(gesture, index);
+    if (t->timer == GESTURE_TIMER_NONE) {
+        node->state = t->next;
+    } else if (gesture->durations_ms[t->timer]) {
+        gesture_arm(gesture, index, base_ms + gesture->durations_ms[t->timer]);
+        node->state = t->next;
+    } else {
+        node->state = t->next_if_off;
+    }
+}
+
+static void gesture_chord_expired(matrix_kbd_gesture_t *gesture, matrix_kbd_gesture_cb_t on_gesture, void *user_ctx)
+{
+    gesture->chord_open = false;
+    if (gesture->nr_chord_keys > 1 && !gesture->chord_overflow && on_gesture) {
+        on_gesture(MATRIX_KBD_EVENT_CHORD, gesture->chord_key_codes, gesture->nr_chord_keys, user_ctx);
+    }
+}
+
+static void gesture_chord_on_key(matrix_kbd_gesture_t *gesture, uint32_t key_code, bool pressed, uint32_t now_ms)
+{
+    if (pressed) {
+        if (!gesture->chord_open) {
+            gesture->chord_open = true;
+            gesture->chord_overflow = false;
+            gesture->nr_chord_keys = 0;
+            gesture_arm(gesture, gesture->nr_keys, now_ms + gesture->chord_window_ms);
+        }
+        // a chord with a key missing is a different chord, rather report none than a truncated one
+        if (gesture->nr_chord_keys < MATRIX_KBD_CHORD_MAX_KEYS) {
+            gesture->chord_key_codes[gesture->nr_chord_keys++] = key_code;
+        } else {
+            gesture->chord_overflow = true;
+        }
+        return;
+    }
+    // a chord is only reported if all its keys are still held when the window closes
+    for (uint32_t i = 0; gesture->chord_open && i < gesture->nr_chord_keys; i++) {
+        if (gesture->chord_key_codes[i] == key_code) {
+            gesture->chord_open = false;
+            gesture_disarm(gesture, gesture->nr_keys);
+        }
+    }
+}
+
+esp_err_t matrix_kbd_gesture_new(uint32_t nr_rows, uint32_t nr_cols, const matrix_kbd_gesture_config_t *config, matrix_kbd_gesture_t **ret_gesture)
+{
+    if (!config || !ret_gesture || !nr_rows || !nr_cols || nr_rows * nr_cols >= MKBD_NODE_NONE) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    uint32_t nr_keys = nr_rows * nr_cols;
+    matrix_kbd_gesture_t *gesture = calloc(1, sizeof(matrix_kbd_gesture_t) + (nr_keys + 1) * sizeof(gesture_node_t));
+    if (!gesture) {
+        return ESP_ERR_NO_MEM;
+    }
+    gesture->nr_cols = nr_cols;
+    gesture->nr_keys = nr_keys;
+    gesture->durations_ms[GESTURE_TIMER_LONG] = config->long_press_ms;
+    // repeats only ever follow a long press
+    gesture->durations_ms[GESTURE_TIMER_REPEAT] = config->long_press_ms ? config->repeat_interval_ms : 0;
+    gesture->durations_ms[GESTURE_TIMER_TAP] = config->double_tap_ms;
+    gesture->chord_window_ms = config->chord_window_ms;
+    matrix_kbd_gesture_reset(gesture, 0);
+    *ret_gesture = gesture;
+    return ESP_OK;
+}
+
+void matrix_kbd_gesture_del(matrix_kbd_gesture_t *gesture)
+{
+    free(gesture);
+}
+
+void matrix_kbd_gesture_reset(matrix_kbd_gesture_t *gesture, uint32_t now_ms)
+{
+    for (int i = 0; i < MKBD_WHEEL_SLOTS; i++) {
+        gesture->slots[i] = MKBD_NODE_NONE;
+    }
+    for (uint32_t i = 0; i <= gesture->nr_keys; i++) {
+        gesture->nodes[i].state = GESTURE_STATE_IDLE;
+        gesture->nodes[i].armed = false;
+    }
+    gesture->chord_open = false;
+    gesture->chord_overflow = false;
+    gesture->nr_chord_keys = 0;
+    gesture->wheel_ms = now_ms;
+}
+
+void matrix_kbd_gesture_tick(matrix_kbd_gesture_t *gesture, uint32_t now_ms, matrix_kbd_gesture_cb_t on_gesture, void *user_ctx)
+{
+    if ((int32_t)(now_ms - gesture->wheel_ms) <= 0) {
+        return;
+    }
+    // after a long idle period one revolution visits every slot, there's no need to walk the whole gap
+    uint32_t steps = now_ms - gesture->wheel_ms;
+    if (steps > MKBD_WHEEL_SLOTS) {
+        steps = MKBD_WHEEL_SLOTS;
+    }
+    for (uint32_t ms = now_ms - steps + 1; steps--; ms++) {
+        uint16_t index = gesture->slots[ms & MKBD_WHEEL_MASK];
+        while (index != MKBD_NODE_NONE) {
+            gesture_node_t *node = &gesture->nodes[index];
+            // the node may be re-armed into this very slot, take its successor first
+            uint16_t next = node->next;
+            if (time_reached(node->deadline_ms, now_ms)) {
+                gesture_disarm(gesture, index);
+                if (index == gesture->nr_keys) {
+                    gesture_chord_expired(gesture, on_gesture, user_ctx);
+                } else {
+                    // chain from the deadline rather than from now, so repeats don't drift with the scan period
+                    gesture_run(gesture, index, GESTURE_INPUT_TIMEOUT, node->deadline_ms, on_gesture, user_ctx);
+                }
+            }
+            index = next;
+        }
+    }
+    gesture->wheel_ms = now_ms;
+}
+
+void matrix_kbd_gesture_on_key(matrix_kbd_gesture_t *gesture, uint32_t row, uint32_t col, bool pressed, uint32_t now_ms,
+                               matrix_kbd_gesture_cb_t on_gesture, void *user_ctx)
+{
+    uint32_t index = row * gesture->nr_cols + col;
+    if (index >= gesture->nr_keys) {
+        return;
+    }
+    matrix_kbd_gesture_tick(gesture, now_ms, on_gesture, user_ctx);
+    if (gesture->chord_window_ms) {
+        gesture_chord_on_key(gesture, MAKE_KEY_CODE(row, col), pressed, now_ms);
+    }
+    gesture_run(gesture, index, pressed ? GESTURE_INPUT_DOWN : GESTURE_INPUT_UP, now_ms, on_gesture, user_ctx);
+}
@@ -0,0 +1,33 @@
+/*
+ * SPDX-FileCopyrightText: 2020-2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "esp_private/matrix_kbd_ghost.h"
+
+bool matrix_kbd_ghost_detect(const uint32_t *raw_rows, uint32_t nr_rows, uint32_t *ambiguous_rows)
+{
+    uint32_t any = 0;
+    for (uint32_t row = 0; row < nr_rows; row++) {
+        ambiguous_rows[row] = 0;
+    }
+    for (uint32_t row = 0; row < nr_rows; row++) {
+        for (uint32_t other = row + 1; other < nr_rows; other++) {
+            uint32_t common = raw_rows[row] & raw_rows[other];
+            // a single shared column is a plain two key press, two or more close a rectangle
+            if (common & (common - 1)) {
+                ambiguous_rows[row] |= common;
+                ambiguous_rows[other] |= common;
+                any |= common;
+            }
+        }
+    }
+    return any != 0;
+}
+
+void matrix_kbd_ghost_block(uint32_t *raw_rows, const uint32_t *stable_rows, const uint32_t *ambiguous_rows, uint32_t nr_rows)
+{
+    for (uint32_t row = 0; row < nr_rows; row++) {
+        raw_rows[row] = (raw_rows[row] & ~ambiguous_rows[row]) | (stable_rows[row] & ambiguous_rows[row]);
+    }
+}
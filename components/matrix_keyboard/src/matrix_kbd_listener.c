@@ -0,0 +1,41 @@
+/*
+ * SPDX-FileCopyrightText: 2020-2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <stddef.h>
+#include "esp_private/matrix_kbd_listener.h"
+
+void matrix_kbd_listeners_set(matrix_kbd_listeners_t *listeners, int index, uint32_t event_mask, matrix_kbd_event_handler handler, void *args)
+{
+    uint32_t mask = 0;
+    listeners->slots[index].event_mask = handler ? event_mask : 0;
+    listeners->slots[index].handler = handler;
+    listeners->slots[index].args = args;
+    for (int i = 0; i < MATRIX_KBD_MAX_LISTENERS + 1; i++) {
+        mask |= listeners->slots[i].event_mask;
+    }
+    listeners->mask = mask;
+}
+
+int matrix_kbd_listeners_add(matrix_kbd_listeners_t *listeners, uint32_t event_mask, matrix_kbd_event_handler handler, void *args)
+{
+    for (int i = 1; i < MATRIX_KBD_MAX_LISTENERS + 1; i++) {
+        if (!listeners->slots[i].handler) {
+            matrix_kbd_listeners_set(listeners, i, event_mask, handler, args);
+            return i;
+        }
+    }
+    return 0;
+}
+
+int matrix_kbd_listeners_remove(matrix_kbd_listeners_t *listeners, matrix_kbd_event_handler handler, void *args)
+{
+    for (int i = 1; i < MATRIX_KBD_MAX_LISTENERS + 1; i++) {
+        if (listeners->slots[i].handler == handler && listeners->slots[i].args == args) {
+            matrix_kbd_listeners_set(listeners, i, 0, NULL, NULL);
+            return i;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,76 @@
+/*
+ * SPDX-FileCopyrightText: 2020-2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include "matrix_keyboard.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Event stored in the dispatch ring
+ */
+typedef struct {
+    matrix_kbd_event_id_t id;        /*!< Event ID */
+    matrix_kbd_event_data_t data;    /*!< Event data handed to the event handler */
+} matrix_kbd_ring_event_t;
+
+/**
+ * @brief Lock-free single-producer/single-consumer event ring
+ *
+ * @note Head and tail are free running counters, the slot index is `counter & mask`.
+ *       Only the producer writes `head` and only the consumer writes `tail`, so no lock is needed.
+ */
+typedef struct {
+    uint32_t mask;                     /*!< Number of slots minus one, slot count must be a power of two */
+    atomic_uint_fast32_t head;         /*!< Next slot to write, owned by the producer */
+    atomic_uint_fast32_t tail;         /*!< Next slot to read, owned by the consumer */
+    atomic_uint_fast32_t dropped;      /*!< Events dropped because the ring was full */
+    matrix_kbd_ring_event_t slots[];   /*!< Event slots */
+} matrix_kbd_ring_t;
+
+static inline void matrix_kbd_ring_init(matrix_kbd_ring_t *ring, uint32_t nr_slots)
+{
+    ring->mask = nr_slots - 1;
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    atomic_init(&ring->dropped, 0);
+}
+
+static inline bool matrix_kbd_ring_push(matrix_kbd_ring_t *ring, const matrix_kbd_ring_event_t *event)
+{
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    if (head - tail > ring->mask) {
+        atomic_fetch_add_explicit(&ring->dropped, 1, memory_order_relaxed);
+        return false;
+    }
+    ring->slots[head & ring->mask] = *event;
+    // publish the slot content before the new head
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+    return true;
+}
+
+static inline bool matrix_kbd_ring_pop(matrix_kbd_ring_t *ring, matrix_kbd_ring_event_t *event)
+{
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    if (tail == head) {
+        return false;
+    }
+    *event = ring->slots[tail & ring->mask];
+    // release the slot back to the producer only after it has been copied out
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+    return true;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -4,16 +4,24 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 #include <stdlib.h>
+#include <string.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "freertos/timers.h"
 #include "esp_compiler.h"
+#include "esp_cpu.h"
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_pm.h"
+#include "esp_sleep.h"
 #include "driver/dedic_gpio.h"
 #include "driver/gpio.h"
 #include "matrix_keyboard.h"
 #include "esp_rom_sys.h"
 #include "esp_mac.h"
+#include "esp_private/matrix_kbd_core.h"
+#include "esp_private/matrix_kbd_listener.h"
+#include "matrix_kbd_ring.h"
+#include "esp_private/matrix_kbd_snapshot.h"
 
 static const char *TAG = "mkbd";
 
@@ -26,6 +34,9 @@ static const char *TAG = "mkbd";
         }                                                                         \
     } while (0)
 
+// Time for a released col line to be pulled back up before it's sampled
+#define MKBD_SCAN_SETTLE_US 2
+
 typedef struct matrix_kbd_t matrix_kbd_t;
 
 struct matrix_kbd_t {
@@ -33,61 +44,255 @@ struct matrix_kbd_t {
     dedic_gpio_bundle_handle_t col_bundle;
     uint32_t nr_row_gpios;
     uint32_t nr_col_gpios;
-    TimerHandle_t debounce_timer;
-    matrix_kbd_event_handler event_handler;
-    void *event_handler_args;
-    uint32_t row_state[0];
+    matrix_kbd_scan_mode_t scan_mode;
+    esp_timer_handle_t scan_timer;
+    uint32_t scan_interval_us;
+    int64_t scan_time_us;
+    int64_t edge_time_us;
+    bool scan_posted;
+    matrix_kbd_core_t *core;
+    matrix_kbd_snapshot_t snapshot;
+    matrix_kbd_latch_t snapshot_latch;
+    int *row_gpios;
+    bool light_sleep_wakeup;
+    volatile bool woke_on_row;      // the last light sleep exit was a GPIO wake up with a row held low
+    bool edge_woke_up;              // edge_time_us is the row edge which woke the chip up
+#if CONFIG_PM_ENABLE
+    esp_pm_lock_handle_t pm_lock;
+    bool pm_locked;
+#endif
+    matrix_kbd_scan_stats_t scan_stats;
+    TaskHandle_t dispatch_task;
+    TaskHandle_t exit_waiter;
+    volatile bool dispatch_exit;
+    portMUX_TYPE listener_lock;
+    matrix_kbd_listeners_t listeners;
+    matrix_kbd_ring_t *event_ring;
+    uint32_t raw_rows[0];
 };
 
-static IRAM_ATTR bool matrix_kbd_row_isr_callback(dedic_gpio_bundle_handle_t row_bundle, uint32_t row_index, void *args)
+static bool matrix_kbd_row_isr_callback(dedic_gpio_bundle_handle_t row_bundle, uint32_t row_index, void *args);
+
+static void matrix_kbd_post_event(matrix_kbd_t *mkbd, matrix_kbd_event_id_t id, const matrix_kbd_event_data_t *data)
 {
-    BaseType_t high_task_wakeup = pdFALSE;
-    matrix_kbd_t *mkbd = (matrix_kbd_t *)args;
+    // nobody listens, don't wake the dispatch task for nothing
+    if (!matrix_kbd_listeners_want(&mkbd->listeners, id)) {
+        return;
+    }
+    matrix_kbd_ring_event_t event = {
+        .id = id,
+        .data = *data,
+    };
+    if (!matrix_kbd_ring_push(mkbd->event_ring, &event)) {
+        ESP_LOGD(TAG, "event queue full, drop event %d of key %04"PRIx32, id, data->key_code);
+    }
+    mkbd->scan_posted = true;
+}
 
-    // temporarily disable interrupt
-    dedic_gpio_bundle_set_interrupt_and_callback(row_bundle, (1 << mkbd->nr_row_gpios) - 1, DEDIC_GPIO_INTR_NONE, NULL, NULL);
-    // get row id, start to check the col id
-    dedic_gpio_bundle_write(row_bundle, 1 << row_index, 0);
-    dedic_gpio_bundle_write(mkbd->col_bundle, (1 << mkbd->nr_col_gpios) - 1, (1 << mkbd->nr_col_gpios) - 1);
-    xTimerStartFromISR(mkbd->debounce_timer, &high_task_wakeup);
-    return high_task_wakeup == pdTRUE;
-}
-
-static void matrix_kbd_debounce_timer_callback(TimerHandle_t xTimer)
-{
-    matrix_kbd_t *mkbd = (matrix_kbd_t *)pvTimerGetTimerID(xTimer);
-
-    uint32_t row_out = dedic_gpio_bundle_read_out(mkbd->row_bundle);
-    uint32_t col_in = dedic_gpio_bundle_read_in(mkbd->col_bundle);
-    row_out = (~row_out) & ((1 << mkbd->nr_row_gpios) - 1);
-    ESP_LOGD(TAG, "row_out=%"PRIx32", col_in=%"PRIx32, row_out, col_in);
-    int row = -1;
-    int col = -1;
-    uint32_t key_code = 0;
-    while (row_out) {
-        row = __builtin_ffs(row_out) - 1;
-        uint32_t changed_col_bits = mkbd->row_state[row] ^ col_in;
-        while (changed_col_bits) {
-            col = __builtin_ffs(changed_col_bits) - 1;
-            ESP_LOGD(TAG, "row=%d, col=%d", row, col);
-            key_code = MAKE_KEY_CODE(row, col);
-            if (col_in & (1 << col)) {
-                mkbd->event_handler(mkbd, MATRIX_KBD_EVENT_UP, (void *)key_code, mkbd->event_handler_args);
-            } else {
-                mkbd->event_handler(mkbd, MATRIX_KBD_EVENT_DOWN, (void *)key_code, mkbd->event_handler_args);
+static void matrix_kbd_dispatch_task(void *args)
+{
+    matrix_kbd_t *mkbd = (matrix_kbd_t *)args;
+    matrix_kbd_ring_event_t event;
+    while (!mkbd->dispatch_exit) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        while (matrix_kbd_ring_pop(mkbd->event_ring, &event)) {
+            for (int i = 0; i < MATRIX_KBD_MAX_LISTENERS + 1; i++) {
+                portENTER_CRITICAL(&mkbd->listener_lock);
+                matrix_kbd_listener_t listener = mkbd->listeners.slots[i];
+                portEXIT_CRITICAL(&mkbd->listener_lock);
+                if (matrix_kbd_listener_wants(&listener, event.id)) {
+                    listener.handler(mkbd, event.id, &event.data, listener.args);
+                }
             }
-            changed_col_bits = changed_col_bits & (changed_col_bits - 1);
         }
-        mkbd->row_state[row] = col_in;
-        row_out = row_out & (row_out - 1);
     }
+    xTaskNotifyGive(mkbd->exit_waiter);
+    vTaskDelete(NULL);
+}
+
+static IRAM_ATTR void matrix_kbd_pm_lock_acquire(matrix_kbd_t *mkbd)
+{
+#if CONFIG_PM_ENABLE
+    if (!mkbd->pm_locked) {
+        esp_pm_lock_acquire(mkbd->pm_lock);
+        mkbd->pm_locked = true;
+    }
+#endif
+}
+
+static void matrix_kbd_pm_lock_release(matrix_kbd_t *mkbd)
+{
+#if CONFIG_PM_ENABLE
+    if (mkbd->pm_locked) {
+        mkbd->pm_locked = false;
+        esp_pm_lock_release(mkbd->pm_lock);
+    }
+#endif
+}
 
+static void matrix_kbd_arm_row_interrupt(matrix_kbd_t *mkbd)
+{
     // row lines set to high level
     dedic_gpio_bundle_write(mkbd->row_bundle, (1 << mkbd->nr_row_gpios) - 1, (1 << mkbd->nr_row_gpios) - 1);
     // col lines set to low level
     dedic_gpio_bundle_write(mkbd->col_bundle, (1 << mkbd->nr_col_gpios) - 1, 0);
-    dedic_gpio_bundle_set_interrupt_and_callback(mkbd->row_bundle, (1 << mkbd->nr_row_gpios) - 1,
-                                                 DEDIC_GPIO_INTR_BOTH_EDGE, matrix_kbd_row_isr_callback, mkbd);
+    // nothing to scan until a key is pressed, let the system enter light sleep
+    // released before enabling the interrupt, so the ISR always finds the lock free and takes it
+    matrix_kbd_pm_lock_release(mkbd);
+    if (mkbd->light_sleep_wakeup) {
+        // a wake up before arming belongs to something else
+        mkbd->woke_on_row = false;
+        // dedicated GPIO interrupts are clocked by the CPU, only GPIO matrix level interrupts can wake it up
+        for (int i = 0; i < mkbd->nr_row_gpios; i++) {
+            gpio_intr_enable(mkbd->row_gpios[i]);
+        }
+    } else {
+        dedic_gpio_bundle_set_interrupt_and_callback(mkbd->row_bundle, (1 << mkbd->nr_row_gpios) - 1,
+                                                     DEDIC_GPIO_INTR_BOTH_EDGE, matrix_kbd_row_isr_callback, mkbd);
+    }
+}
+
+static void matrix_kbd_disarm_row_interrupt(matrix_kbd_t *mkbd)
+{
+    if (mkbd->light_sleep_wakeup) {
+        for (int i = 0; i < mkbd->nr_row_gpios; i++) {
+            gpio_intr_disable(mkbd->row_gpios[i]);
+        }
+    } else {
+        dedic_gpio_bundle_set_interrupt_and_callback(mkbd->row_bundle, (1 << mkbd->nr_row_gpios) - 1,
+                                                     DEDIC_GPIO_INTR_NONE, NULL, NULL);
+    }
+}
+
+#if CONFIG_PM_LIGHT_SLEEP_CALLBACKS
+// Runs on every exit from automatic light sleep, before the row interrupt which the wake up left pending
+static IRAM_ATTR esp_err_t matrix_kbd_sleep_exit_cb(int64_t sleep_time_us, void *args)
+{
+    matrix_kbd_t *mkbd = (matrix_kbd_t *)args;
+    // the wake up cause sticks until the next sleep, it's only this wake up's cause right here
+    mkbd->woke_on_row = esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_GPIO &&
+                        dedic_gpio_bundle_read_in(mkbd->row_bundle) != (1 << mkbd->nr_row_gpios) - 1;
+    return ESP_OK;
+}
+#endif
+
+static void matrix_kbd_row_wakeup_isr(void *args)
+{
+    matrix_kbd_t *mkbd = (matrix_kbd_t *)args;
+
+    mkbd->edge_time_us = esp_timer_get_time();
+    mkbd->edge_woke_up = mkbd->woke_on_row;
+    mkbd->woke_on_row = false;
+    // the row lines are level triggered, keep them quiet while the scan tick drives them
+    for (int i = 0; i < mkbd->nr_row_gpios; i++) {
+        gpio_intr_disable(mkbd->row_gpios[i]);
+    }
+    matrix_kbd_pm_lock_acquire(mkbd);
+    esp_timer_start_periodic(mkbd->scan_timer, mkbd->scan_interval_us);
+}
+
+static IRAM_ATTR bool matrix_kbd_row_isr_callback(dedic_gpio_bundle_handle_t row_bundle, uint32_t row_index, void *args)
+{
+    matrix_kbd_t *mkbd = (matrix_kbd_t *)args;
+
+    mkbd->edge_time_us = esp_timer_get_time();
+    matrix_kbd_pm_lock_acquire(mkbd);
+    // the scan tick drives the row lines itself, disable interrupt until every key is released and settled
+    dedic_gpio_bundle_set_interrupt_and_callback(row_bundle, (1 << mkbd->nr_row_gpios) - 1, DEDIC_GPIO_INTR_NONE, NULL, NULL);
+    esp_timer_start_periodic(mkbd->scan_timer, mkbd->scan_interval_us);
+    return false;
+}
+
+// Undo the light sleep wake up setup of matrix_kbd_install, also after a partial one
+static void matrix_kbd_remove_wakeup(matrix_kbd_t *mkbd)
+{
+#if CONFIG_PM_LIGHT_SLEEP_CALLBACKS
+    esp_pm_sleep_cbs_register_config_t sleep_cbs = {
+        .exit_cb = matrix_kbd_sleep_exit_cb,
+        .exit_cb_user_arg = mkbd,
+    };
+    esp_pm_light_sleep_unregister_cbs(&sleep_cbs);
+#endif
+    for (int i = 0; i < mkbd->nr_row_gpios; i++) {
+        gpio_wakeup_disable(mkbd->row_gpios[i]);
+        gpio_isr_handler_remove(mkbd->row_gpios[i]);
+    }
+}
+
+static void matrix_kbd_scan_rows(matrix_kbd_t *mkbd)
+{
+    uint32_t row_mask = (1 << mkbd->nr_row_gpios) - 1;
+    uint32_t col_mask = (1 << mkbd->nr_col_gpios) - 1;
+    // release col lines, they are pulled up and read back
+    dedic_gpio_bundle_write(mkbd->col_bundle, col_mask, col_mask);
+    for (int row = 0; row < mkbd->nr_row_gpios; row++) {
+        // drive one row low at a time, a pressed key pulls its col line low
+        dedic_gpio_bundle_write(mkbd->row_bundle, row_mask, row_mask & ~(1 << row));
+        esp_rom_delay_us(MKBD_SCAN_SETTLE_US);
+        mkbd->raw_rows[row] = ~dedic_gpio_bundle_read_in(mkbd->col_bundle) & col_mask;
+    }
+}
+
+static void matrix_kbd_on_core_event(matrix_kbd_event_id_t id, const matrix_kbd_event_data_t *data, void *user_ctx)
+{
+    matrix_kbd_t *mkbd = (matrix_kbd_t *)user_ctx;
+    ESP_LOGD(TAG, "event=%d, key=%04"PRIx32, id, data->key_code);
+    // the core hands the edge to one key down only, so does the wake up
+    if (data->edge_time_us && mkbd->edge_woke_up) {
+        matrix_kbd_event_data_t wake_data = *data;
+        wake_data.woke_up = true;
+        mkbd->edge_woke_up = false;
+        matrix_kbd_post_event(mkbd, id, &wake_data);
+        return;
+    }
+    matrix_kbd_post_event(mkbd, id, data);
+}
+
+static void matrix_kbd_scan_timer_callback(void *args)
+{
+    matrix_kbd_t *mkbd = (matrix_kbd_t *)args;
+
+    uint32_t start_cycles = esp_cpu_get_cycle_count();
+    mkbd->scan_time_us = esp_timer_get_time();
+    mkbd->scan_posted = false;
+    matrix_kbd_scan_rows(mkbd);
+    bool busy = matrix_kbd_core_scan(mkbd->core, mkbd->raw_rows, mkbd->scan_time_us, &mkbd->edge_time_us);
+
+    // publish all keys of this scan at once, readers never see keys from two different scans
+    mkbd->snapshot.seq++;
+    mkbd->snapshot.scan_time_us = mkbd->scan_time_us;
+    matrix_kbd_core_pack_state(mkbd->core, mkbd->snapshot.keys);
+    matrix_kbd_latch_publish(&mkbd->snapshot_latch, &mkbd->snapshot);
+
+    // defer the user handler to the dispatch task, never run it in the timer task
+    if (mkbd->scan_posted) {
+        xTaskNotifyGive(mkbd->dispatch_task);
+    }
+
+    uint32_t scan_cycles = esp_cpu_get_cycle_count() - start_cycles;
+    mkbd->scan_stats.nr_scans++;
+    mkbd->scan_stats.total_scan_cycles += scan_cycles;
+    if (scan_cycles > mkbd->scan_stats.max_scan_cycles) {
+        mkbd->scan_stats.max_scan_cycles = scan_cycles;
+    }
+
+    // periodic mode keeps scanning until the driver is stopped
+    if (busy || mkbd->scan_mode == MATRIX_KBD_SCAN_MODE_PERIODIC) {
+        return;
+    }
+
+    // every key is released and settled, stop scanning and wait for the next row edge
+    esp_timer_stop(mkbd->scan_timer);
+    // an edge which only produced a glitch must not be credited to the next key press
+    mkbd->edge_time_us = 0;
+    mkbd->edge_woke_up = false;
+    matrix_kbd_arm_row_interrupt(mkbd);
+    // a key pressed between the last scan and arming the edge interrupt produced no edge, catch it here
+    // level triggered wake up interrupts fire on their own in that case
+    if (!mkbd->light_sleep_wakeup && dedic_gpio_bundle_read_in(mkbd->row_bundle) != (1 << mkbd->nr_row_gpios) - 1) {
+        matrix_kbd_disarm_row_interrupt(mkbd);
+        esp_timer_start_periodic(mkbd->scan_timer, mkbd->scan_interval_us);
+    }
 }
 
 esp_err_t matrix_kbd_install(const matrix_kbd_config_t *config, matrix_kbd_handle_t *mkbd_handle)
@@ -96,12 +301,26 @@ esp_err_t matrix_kbd_install(const matrix_kbd_config_t *config, matrix_kbd_handl
     matrix_kbd_t *mkbd = NULL;
     MKBD_CHECK(config, "matrix keyboard configuration can't be null", err, ESP_ERR_INVALID_ARG);
     MKBD_CHECK(mkbd_handle, "matrix keyboard handle can't be null", err, ESP_ERR_INVALID_ARG);
+    MKBD_CHECK(config->event_queue_size && !(config->event_queue_size & (config->event_queue_size - 1)),
+               "event queue size must be a power of two", err, ESP_ERR_INVALID_ARG);
+    MKBD_CHECK(config->scan_interval_us, "scan interval can't be zero", err, ESP_ERR_INVALID_ARG);
+    MKBD_CHECK(config->nr_row_gpios * config->nr_col_gpios <= MATRIX_KBD_MAX_KEYS, "too many keys", err, ESP_ERR_INVALID_ARG);
+    MKBD_CHECK(config->scan_mode == MATRIX_KBD_SCAN_MODE_INTERRUPT || config->scan_mode == MATRIX_KBD_SCAN_MODE_PERIODIC,
+               "invalid scan mode", err, ESP_ERR_INVALID_ARG);
 
-    mkbd = calloc(1, sizeof(matrix_kbd_t) + (config->nr_row_gpios) * sizeof(uint32_t));
+    // raw rows of the current scan, followed by the row GPIO numbers
+    mkbd = calloc(1, sizeof(matrix_kbd_t) + config->nr_row_gpios * (sizeof(uint32_t) + sizeof(int)));
     MKBD_CHECK(mkbd, "allocate matrix keyboard context failed", err, ESP_ERR_NO_MEM);
 
     mkbd->nr_col_gpios = config->nr_col_gpios;
     mkbd->nr_row_gpios = config->nr_row_gpios;
+    mkbd->scan_mode = config->scan_mode;
+    mkbd->row_gpios = (int *)(mkbd->raw_rows + config->nr_row_gpios);
+    for (int i = 0; i < config->nr_row_gpios; i++) {
+        mkbd->row_gpios[i] = config->row_gpios[i];
+    }
+    matrix_kbd_latch_init(&mkbd->snapshot_latch);
+    portMUX_INITIALIZE(&mkbd->listener_lock);
 
     // GPIO pad configuration
     // Each GPIO used in matrix key board should be able to input and output
@@ -150,16 +369,91 @@ esp_err_t matrix_kbd_install(const matrix_kbd_config_t *config, matrix_kbd_handl
     dedic_gpio_bundle_set_interrupt_and_callback(mkbd->col_bundle, (1 << config->nr_col_gpios) - 1,
                                                  DEDIC_GPIO_INTR_NONE, NULL, NULL);
 
-    // Create a ont-shot os timer, used for key debounce
-    mkbd->debounce_timer = xTimerCreate("kb_debounce", pdMS_TO_TICKS(config->debounce_ms), pdFALSE, mkbd, matrix_kbd_debounce_timer_callback);
-    MKBD_CHECK(mkbd->debounce_timer, "create debounce timer failed", err, ESP_FAIL);
+    if (config->light_sleep_wakeup) {
+        // A pressed key pulls its row low while the cols are driven low, wake up on that level
+        esp_err_t isr_ret = gpio_install_isr_service(0);
+        MKBD_CHECK(isr_ret == ESP_OK || isr_ret == ESP_ERR_INVALID_STATE, "install gpio isr service failed", err, ESP_FAIL);
+        // set first, so the error path below removes whatever got registered
+        mkbd->light_sleep_wakeup = true;
+        for (int i = 0; i < config->nr_row_gpios; i++) {
+            MKBD_CHECK(gpio_isr_handler_add(config->row_gpios[i], matrix_kbd_row_wakeup_isr, mkbd) == ESP_OK,
+                       "add row %d isr handler failed", err, ESP_FAIL, config->row_gpios[i]);
+            gpio_wakeup_enable(config->row_gpios[i], GPIO_INTR_LOW_LEVEL);
+            gpio_intr_disable(config->row_gpios[i]);
+        }
+        MKBD_CHECK(esp_sleep_enable_gpio_wakeup() == ESP_OK, "enable gpio wakeup failed", err, ESP_FAIL);
+#if CONFIG_PM_LIGHT_SLEEP_CALLBACKS
+        // tells the key press which woke the chip up apart from one pressed while awake
+        esp_pm_sleep_cbs_register_config_t sleep_cbs = {
+            .exit_cb = matrix_kbd_sleep_exit_cb,
+            .exit_cb_user_arg = mkbd,
+        };
+        MKBD_CHECK(esp_pm_light_sleep_register_cbs(&sleep_cbs) == ESP_OK, "register light sleep callback failed", err, ESP_FAIL);
+#endif
+    }
+#if CONFIG_PM_ENABLE
+    // Held while scanning, so light sleep never cuts a scan burst
+    MKBD_CHECK(esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "mkbd", &mkbd->pm_lock) == ESP_OK,
+               "create pm lock failed", err, ESP_FAIL);
+#endif
+
+    // Ghost detection, debounce and gestures live in the hardware independent core, this file only samples the matrix
+    // Each key integrates over debounce_ms worth of scans
+    uint32_t threshold = config->debounce_ms * 1000 / config->scan_interval_us;
+    matrix_kbd_core_config_t core_config = {
+        .nr_rows = config->nr_row_gpios,
+        .nr_cols = config->nr_col_gpios,
+        .debounce_threshold = threshold ? threshold : 1,
+        .ghost_mode = config->ghost_mode,
+        .gesture = {
+            .long_press_ms = config->long_press_ms,
+            .repeat_interval_ms = config->repeat_interval_ms,
+            .double_tap_ms = config->double_tap_ms,
+            .chord_window_ms = config->chord_window_ms,
+        },
+    };
+    MKBD_CHECK(matrix_kbd_core_new(&core_config, matrix_kbd_on_core_event, mkbd, &mkbd->core) == ESP_OK,
+               "create keyboard core failed", err, ESP_ERR_INVALID_ARG);
+
+    // Create a periodic scan timer, shared by all keys
+    // In interrupt mode it only runs while a key is pressed or settling, in periodic mode it runs from start to stop
+    esp_timer_create_args_t scan_timer_args = {
+        .callback = matrix_kbd_scan_timer_callback,
+        .arg = mkbd,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "kb_scan",
+    };
+    MKBD_CHECK(esp_timer_create(&scan_timer_args, &mkbd->scan_timer) == ESP_OK, "create scan timer failed", err, ESP_FAIL);
+    mkbd->scan_interval_us = config->scan_interval_us;
+
+    mkbd->event_ring = calloc(1, sizeof(matrix_kbd_ring_t) + config->event_queue_size * sizeof(matrix_kbd_ring_event_t));
+    MKBD_CHECK(mkbd->event_ring, "allocate event queue failed", err, ESP_ERR_NO_MEM);
+    matrix_kbd_ring_init(mkbd->event_ring, config->event_queue_size);
+
+    MKBD_CHECK(xTaskCreate(matrix_kbd_dispatch_task, "kb_dispatch", config->task_stack_size, mkbd,
+                           config->task_priority, &mkbd->dispatch_task) == pdPASS,
+               "create dispatch task failed", err, ESP_ERR_NO_MEM);
 
     * mkbd_handle = mkbd;
     return ESP_OK;
 err:
     if (mkbd) {
-        if (mkbd->debounce_timer) {
-            xTimerDelete(mkbd->debounce_timer, 0);
+        if (mkbd->event_ring) {
+            free(mkbd->event_ring);
+        }
+        if (mkbd->scan_timer) {
+            esp_timer_delete(mkbd->scan_timer);
+        }
+        if (mkbd->light_sleep_wakeup) {
+            matrix_kbd_remove_wakeup(mkbd);
+        }
+#if CONFIG_PM_ENABLE
+        if (mkbd->pm_lock) {
+            esp_pm_lock_delete(mkbd->pm_lock);
+        }
+#endif
+        if (mkbd->core) {
+            matrix_kbd_core_del(mkbd->core);
         }
         if (mkbd->col_bundle) {
             dedic_gpio_del_bundle(mkbd->col_bundle);
@@ -176,9 +470,28 @@ esp_err_t matrix_kbd_uninstall(matrix_kbd_handle_t mkbd_handle)
 {
     esp_err_t ret_code = ESP_OK;
     MKBD_CHECK(mkbd_handle, "matrix keyboard handle can't be null", err, ESP_ERR_INVALID_ARG);
-    xTimerDelete(mkbd_handle->debounce_timer, 0);
+    // the row interrupts start the scan timer, take them away before the timer goes
+    matrix_kbd_disarm_row_interrupt(mkbd_handle);
+    if (mkbd_handle->light_sleep_wakeup) {
+        matrix_kbd_remove_wakeup(mkbd_handle);
+    }
+    esp_timer_stop(mkbd_handle->scan_timer);
+    // a scan which was already running re-arms the dedicated GPIO interrupt once all keys are released
+    matrix_kbd_disarm_row_interrupt(mkbd_handle);
+    esp_timer_delete(mkbd_handle->scan_timer);
+    // let the dispatch task finish the handler it may be running, then wait for it to exit
+    mkbd_handle->exit_waiter = xTaskGetCurrentTaskHandle();
+    mkbd_handle->dispatch_exit = true;
+    xTaskNotifyGive(mkbd_handle->dispatch_task);
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+#if CONFIG_PM_ENABLE
+    matrix_kbd_pm_lock_release(mkbd_handle);
+    esp_pm_lock_delete(mkbd_handle->pm_lock);
+#endif
     dedic_gpio_del_bundle(mkbd_handle->col_bundle);
     dedic_gpio_del_bundle(mkbd_handle->row_bundle);
+    matrix_kbd_core_del(mkbd_handle->core);
+    free(mkbd_handle->event_ring);
     free(mkbd_handle);
     return ESP_OK;
 err:
@@ -190,19 +503,18 @@ esp_err_t matrix_kbd_start(matrix_kbd_handle_t mkbd_handle)
     esp_err_t ret_code = ESP_OK;
     MKBD_CHECK(mkbd_handle, "matrix keyboard handle can't be null", err, ESP_ERR_INVALID_ARG);
 
-    // row lines set to high level
-    dedic_gpio_bundle_write(mkbd_handle->row_bundle, (1 << mkbd_handle->nr_row_gpios) - 1, (1 << mkbd_handle->nr_row_gpios) - 1);
-    // col lines set to low level
-    dedic_gpio_bundle_write(mkbd_handle->col_bundle, (1 << mkbd_handle->nr_col_gpios) - 1, 0);
-
-    for (int i = 0; i < mkbd_handle->nr_row_gpios; i++) {
-        mkbd_handle->row_state[i] = (1 << mkbd_handle->nr_col_gpios) - 1;
+    matrix_kbd_core_reset(mkbd_handle->core, esp_timer_get_time());
+    memset(&mkbd_handle->scan_stats, 0, sizeof(mkbd_handle->scan_stats));
+    if (mkbd_handle->scan_mode == MATRIX_KBD_SCAN_MODE_PERIODIC) {
+        // row lines are driven by the scan tick only, no interrupt involved, and the system stays awake
+        matrix_kbd_pm_lock_acquire(mkbd_handle);
+        MKBD_CHECK(esp_timer_start_periodic(mkbd_handle->scan_timer, mkbd_handle->scan_interval_us) == ESP_OK,
+                   "start scan timer failed", err, ESP_FAIL);
+    } else {
+        // only enable row line interrupt, scanning starts on the first edge
+        matrix_kbd_arm_row_interrupt(mkbd_handle);
     }
 
-    // only enable row line interrupt
-    dedic_gpio_bundle_set_interrupt_and_callback(mkbd_handle->row_bundle, (1 << mkbd_handle->nr_row_gpios) - 1,
-                                                 DEDIC_GPIO_INTR_BOTH_EDGE, matrix_kbd_row_isr_callback, mkbd_handle);
-
     return ESP_OK;
 err:
     return ret_code;
@@ -213,13 +525,12 @@ esp_err_t matrix_kbd_stop(matrix_kbd_handle_t mkbd_handle)
     esp_err_t ret_code = ESP_OK;
     MKBD_CHECK(mkbd_handle, "matrix keyboard handle can't be null", err, ESP_ERR_INVALID_ARG);
 
-    xTimerStop(mkbd_handle->debounce_timer, 0);
-
     // Disable interrupt
-    dedic_gpio_bundle_set_interrupt_and_callback(mkbd_handle->row_bundle, (1 << mkbd_handle->nr_row_gpios) - 1,
-                                                 DEDIC_GPIO_INTR_NONE, NULL, NULL);
+    matrix_kbd_disarm_row_interrupt(mkbd_handle);
     dedic_gpio_bundle_set_interrupt_and_callback(mkbd_handle->col_bundle, (1 << mkbd_handle->nr_col_gpios) - 1,
                                                  DEDIC_GPIO_INTR_NONE, NULL, NULL);
+    esp_timer_stop(mkbd_handle->scan_timer);
+    matrix_kbd_pm_lock_release(mkbd_handle);
 
     return ESP_OK;
 err:
@@ -230,8 +541,75 @@ esp_err_t matrix_kbd_register_event_handler(matrix_kbd_handle_t mkbd_handle, mat
 {
     esp_err_t ret_code = ESP_OK;
     MKBD_CHECK(mkbd_handle, "matrix keyboard handle can't be null", err, ESP_ERR_INVALID_ARG);
-    mkbd_handle->event_handler = handler;
-    mkbd_handle->event_handler_args = args;
+    portENTER_CRITICAL(&mkbd_handle->listener_lock);
+    matrix_kbd_listeners_set(&mkbd_handle->listeners, 0, MATRIX_KBD_EVENT_MASK_ALL, handler, args);
+    portEXIT_CRITICAL(&mkbd_handle->listener_lock);
+    return ESP_OK;
+err:
+    return ret_code;
+}
+
+esp_err_t matrix_kbd_add_listener(matrix_kbd_handle_t mkbd_handle, uint32_t event_mask, matrix_kbd_event_handler handler, void *args)
+{
+    esp_err_t ret_code = ESP_OK;
+    int index = 0;
+    MKBD_CHECK(mkbd_handle, "matrix keyboard handle can't be null", err, ESP_ERR_INVALID_ARG);
+    MKBD_CHECK(handler, "handler can't be null", err, ESP_ERR_INVALID_ARG);
+    MKBD_CHECK(event_mask, "event mask can't be empty", err, ESP_ERR_INVALID_ARG);
+    portENTER_CRITICAL(&mkbd_handle->listener_lock);
+    index = matrix_kbd_listeners_add(&mkbd_handle->listeners, event_mask, handler, args);
+    portEXIT_CRITICAL(&mkbd_handle->listener_lock);
+    MKBD_CHECK(index, "no free listener slot", err, ESP_ERR_NO_MEM);
+    return ESP_OK;
+err:
+    return ret_code;
+}
+
+esp_err_t matrix_kbd_remove_listener(matrix_kbd_handle_t mkbd_handle, matrix_kbd_event_handler handler, void *args)
+{
+    esp_err_t ret_code = ESP_OK;
+    int index = 0;
+    MKBD_CHECK(mkbd_handle, "matrix keyboard handle can't be null", err, ESP_ERR_INVALID_ARG);
+    MKBD_CHECK(handler, "handler can't be null", err, ESP_ERR_INVALID_ARG);
+    portENTER_CRITICAL(&mkbd_handle->listener_lock);
+    index = matrix_kbd_listeners_remove(&mkbd_handle->listeners, handler, args);
+    portEXIT_CRITICAL(&mkbd_handle->listener_lock);
+    MKBD_CHECK(index, "listener not found", err, ESP_ERR_NOT_FOUND);
+    return ESP_OK;
+err:
+    return ret_code;
+}
+
+esp_err_t matrix_kbd_get_dropped_events(matrix_kbd_handle_t mkbd_handle, uint32_t *dropped)
+{
+    esp_err_t ret_code = ESP_OK;
+    MKBD_CHECK(mkbd_handle, "matrix keyboard handle can't be null", err, ESP_ERR_INVALID_ARG);
+    MKBD_CHECK(dropped, "dropped can't be null", err, ESP_ERR_INVALID_ARG);
+    *dropped = atomic_load(&mkbd_handle->event_ring->dropped);
+    return ESP_OK;
+err:
+    return ret_code;
+}
+
+esp_err_t matrix_kbd_get_snapshot(matrix_kbd_handle_t mkbd_handle, matrix_kbd_snapshot_t *snapshot)
+{
+    esp_err_t ret_code = ESP_OK;
+    MKBD_CHECK(mkbd_handle, "matrix keyboard handle can't be null", err, ESP_ERR_INVALID_ARG);
+    MKBD_CHECK(snapshot, "snapshot can't be null", err, ESP_ERR_INVALID_ARG);
+    matrix_kbd_latch_read(&mkbd_handle->snapshot_latch, snapshot);
+    return ESP_OK;
+err:
+    return ret_code;
+}
+
+esp_err_t matrix_kbd_get_scan_stats(matrix_kbd_handle_t mkbd_handle, matrix_kbd_scan_stats_t *stats)
+{
+    esp_err_t ret_code = ESP_OK;
+    MKBD_CHECK(mkbd_handle, "matrix keyboard handle can't be null", err, ESP_ERR_INVALID_ARG);
+    MKBD_CHECK(stats, "stats can't be null", err, ESP_ERR_INVALID_ARG);
+    // written by the scan tick only, a torn read of the 64 bit sum is acceptable for statistics
+    *stats = mkbd_handle->scan_stats;
+    stats->nr_ghost_scans = matrix_kbd_core_get_ghost_scans(mkbd_handle->core);
     return ESP_OK;
 err:
     return ret_code;
@@ -0,0 +1,124 @@
+/*
+ * SPDX-FileCopyrightText: 2020-2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "unity.h"
+#include "mkbd_sim.h"
+
+// Contacts of a bouncing key make and break every few tens of microseconds
+#define MKBD_SIM_BOUNCE_CHUNK_US 50
+
+void mkbd_sim_add_key(mkbd_sim_t *sim, uint32_t row, uint32_t col, int64_t press_us, int64_t release_us, uint32_t bounce_us)
+{
+    TEST_ASSERT_LESS_THAN(MKBD_SIM_MAX_KEYS, sim->nr_keys);
+    sim->keys[sim->nr_keys++] = (mkbd_sim_key_t) {
+        .row = row,
+        .col = col,
+        .press_us = press_us,
+        .release_us = release_us,
+        .bounce_us = bounce_us,
+    };
+}
+
+// Level of a contact inside a bounce burst, random but the same for the same seed, key and time
+static bool mkbd_sim_bounce_level(const mkbd_sim_t *sim, size_t key, int64_t time_us)
+{
+    uint32_t x = sim->seed ^ (uint32_t)(key * 0x9E3779B9u) ^ (uint32_t)(time_us / MKBD_SIM_BOUNCE_CHUNK_US);
+    x ^= x >> 16;
+    x *= 0x7FEB352Du;
+    x ^= x >> 15;
+    x *= 0x846CA68Bu;
+    x ^= x >> 16;
+    return x & 1;
+}
+
+static bool mkbd_sim_key_closed(const mkbd_sim_t *sim, size_t key, int64_t time_us)
+{
+    const mkbd_sim_key_t *k = &sim->keys[key];
+    if (time_us < k->press_us) {
+        return false;
+    }
+    if (time_us < k->press_us + k->bounce_us) {
+        return mkbd_sim_bounce_level(sim, key, time_us);
+    }
+    if (!k->release_us || time_us < k->release_us) {
+        return true;
+    }
+    if (time_us < k->release_us + k->bounce_us) {
+        return mkbd_sim_bounce_level(sim, key, time_us);
+    }
+    return false;
+}
+
+void mkbd_sim_sample(const mkbd_sim_t *sim, int64_t time_us, uint32_t *raw_rows)
+{
+    memset(raw_rows, 0, sim->nr_rows * sizeof(uint32_t));
+    for (size_t i = 0; i < sim->nr_keys; i++) {
+        if (mkbd_sim_key_closed(sim, i, time_us)) {
+            raw_rows[sim->keys[i].row] |= 1u << sim->keys[i].col;
+        }
+    }
+    if (!sim->ghosting) {
+        return;
+    }
+    // without diodes, the driven row reaches every column connected to it through a chain of closed keys
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (uint32_t i = 0; i < sim->nr_rows; i++) {
+            for (uint32_t j = 0; j < sim->nr_rows; j++) {
+                if ((raw_rows[i] & raw_rows[j]) && (raw_rows[i] | raw_rows[j]) != raw_rows[i]) {
+                    raw_rows[i] |= raw_rows[j];
+                    changed = true;
+                }
+            }
+        }
+    }
+}
+
+static void mkbd_sim_record(matrix_kbd_event_id_t id, const matrix_kbd_event_data_t *data, void *user_ctx)
+{
+    mkbd_sim_t *sim = (mkbd_sim_t *)user_ctx;
+    if (sim->nr_events < MKBD_SIM_MAX_EVENTS) {
+        sim->events[sim->nr_events].id = id;
+        sim->events[sim->nr_events].data = *data;
+    }
+    sim->nr_events++;
+}
+
+static uint64_t mkbd_sim_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+void mkbd_sim_run(mkbd_sim_t *sim, const matrix_kbd_core_config_t *config, int64_t end_us)
+{
+    matrix_kbd_core_config_t core_config = *config;
+    core_config.nr_rows = sim->nr_rows;
+    core_config.nr_cols = sim->nr_cols;
+    matrix_kbd_core_t *core = NULL;
+    TEST_ESP_OK(matrix_kbd_core_new(&core_config, mkbd_sim_record, sim, &core));
+    uint32_t *raw_rows = calloc(sim->nr_rows, sizeof(uint32_t));
+    TEST_ASSERT_TRUE(raw_rows);
+
+    sim->nr_events = 0;
+    sim->nr_scans = 0;
+    sim->scan_ns = 0;
+    for (int64_t now_us = sim->scan_interval_us; now_us <= end_us; now_us += sim->scan_interval_us) {
+        mkbd_sim_sample(sim, now_us, raw_rows);
+        uint64_t start_ns = mkbd_sim_now_ns();
+        matrix_kbd_core_scan(core, raw_rows, now_us, NULL);
+        sim->scan_ns += mkbd_sim_now_ns() - start_ns;
+        sim->nr_scans++;
+    }
+
+    free(raw_rows);
+    matrix_kbd_core_del(core);
+}
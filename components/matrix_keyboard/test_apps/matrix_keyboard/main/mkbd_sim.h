@@ -0,0 +1,71 @@
+/*
+ * SPDX-FileCopyrightText: 2020-2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_private/matrix_kbd_core.h"
+
+#define MKBD_SIM_MAX_KEYS   16
+#define MKBD_SIM_MAX_EVENTS 64
+
+/**
+ * @brief One press of one key, as seen on the wire
+ */
+typedef struct {
+    uint32_t row;         /*!< Row of the key */
+    uint32_t col;         /*!< Column of the key */
+    int64_t press_us;     /*!< Time of the first contact */
+    int64_t release_us;   /*!< Time of the first break, 0 if the key is held until the end of the run */
+    uint32_t bounce_us;   /*!< Length of the bounce burst following each edge */
+} mkbd_sim_key_t;
+
+/**
+ * @brief Event reported by the core, as recorded by the simulator
+ */
+typedef struct {
+    matrix_kbd_event_id_t id;     /*!< Event ID */
+    matrix_kbd_event_data_t data; /*!< Event data */
+} mkbd_sim_event_t;
+
+/**
+ * @brief Matrix keyboard simulator
+ *
+ * @note The simulator samples generated waveforms every `scan_interval_us`, feeds them to a core like
+ *       the dedicated GPIO backend does in periodic scan mode, and records the events coming out.
+ */
+typedef struct {
+    uint32_t nr_rows;                             /*!< Number of rows */
+    uint32_t nr_cols;                             /*!< Number of columns */
+    uint32_t scan_interval_us;                    /*!< Time between two scans */
+    bool ghosting;                                /*!< Model a matrix without diodes, pressed keys connect their rows and columns */
+    uint32_t seed;                                /*!< Seed of the bounce bursts */
+    size_t nr_keys;                               /*!< Number of key presses */
+    mkbd_sim_key_t keys[MKBD_SIM_MAX_KEYS];       /*!< Key presses */
+    size_t nr_events;                             /*!< Number of events reported, may exceed `MKBD_SIM_MAX_EVENTS` */
+    mkbd_sim_event_t events[MKBD_SIM_MAX_EVENTS]; /*!< First events reported */
+    uint32_t nr_scans;                            /*!< Number of scans fed to the core */
+    uint64_t scan_ns;                             /*!< Time spent in `matrix_kbd_core_scan`, in nanoseconds */
+} mkbd_sim_t;
+
+/**
+ * @brief Add a key press to the simulation
+ */
+void mkbd_sim_add_key(mkbd_sim_t *sim, uint32_t row, uint32_t col, int64_t press_us, int64_t release_us, uint32_t bounce_us);
+
+/**
+ * @brief Sample the matrix, as a scan would read it at `time_us`
+ *
+ * @param[out] raw_rows Array of `nr_rows` bitmaps
+ */
+void mkbd_sim_sample(const mkbd_sim_t *sim, int64_t time_us, uint32_t *raw_rows);
+
+/**
+ * @brief Create a core for the simulated matrix, scan it from time 0 to `end_us`, record its events and delete it
+ *
+ * @param[in] config Configuration of the core, `nr_rows` and `nr_cols` are taken from the simulator
+ */
+void mkbd_sim_run(mkbd_sim_t *sim, const matrix_kbd_core_config_t *config, int64_t end_us);
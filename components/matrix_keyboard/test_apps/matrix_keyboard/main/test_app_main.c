@@ -0,0 +1,16 @@
+/*
+ * SPDX-FileCopyrightText: 2020-2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include <stdio.h>
+#include "unity.h"
+#include "sdkconfig.h"
+
+void app_main(void)
+{
+    printf("Matrix keyboard test app\n");
+
+    unity_run_menu();
+}
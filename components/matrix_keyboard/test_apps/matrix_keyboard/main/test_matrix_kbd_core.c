@@ -0,0 +1,39 @@
+/*
+ * SPDX-FileCopyrightText: 2020-2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include "unity.h"
+#include "esp_private/matrix_kbd_core.h"
+
+static void ignore_event(matrix_kbd_event_id_t id, const matrix_kbd_event_data_t *data, void *user_ctx)
+{
+}
+
+TEST_CASE("core packs the matrix state into one bitmap", "[mkbd]")
+{
+    // 3 rows of 12 keys, row 2 straddles the first two words
+    matrix_kbd_core_config_t config = {
+        .nr_rows = 3,
+        .nr_cols = 12,
+        .debounce_threshold = 1,
+        .ghost_mode = MATRIX_KBD_GHOST_OFF,
+    };
+    matrix_kbd_core_t *core = NULL;
+    TEST_ESP_OK(matrix_kbd_core_new(&config, ignore_event, NULL, &core));
+    uint32_t raw_rows[3] = {1 << 11, 1 << 5, (1 << 0) | (1 << 10)};
+    matrix_kbd_core_scan(core, raw_rows, 1000, NULL);
+
+    uint32_t keys[MATRIX_KBD_MAX_KEYS / 32] = {0};
+    matrix_kbd_core_pack_state(core, keys);
+    TEST_ASSERT_EQUAL_HEX32((1 << 11) | (1 << 17) | (1 << 24), keys[0]);
+    TEST_ASSERT_EQUAL_HEX32(1 << 2, keys[1]);
+
+    matrix_kbd_snapshot_t snapshot = {0};
+    matrix_kbd_core_pack_state(core, snapshot.keys);
+    TEST_ASSERT_TRUE(MATRIX_KBD_SNAPSHOT_KEY_PRESSED(&snapshot, 12, 2, 10));
+    TEST_ASSERT_TRUE(MATRIX_KBD_SNAPSHOT_KEY_PRESSED(&snapshot, 12, 0, 11));
+    TEST_ASSERT_FALSE(MATRIX_KBD_SNAPSHOT_KEY_PRESSED(&snapshot, 12, 2, 11));
+    matrix_kbd_core_del(core);
+}
@@ -0,0 +1,166 @@
+/*
+ * SPDX-FileCopyrightText: 2020-2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include <string.h>
+#include "unity.h"
+#include "esp_private/matrix_kbd_debounce.h"
+
+#define TEST_ROWS 4
+#define TEST_COLS 4
+#define TEST_MAX_EDGES 32
+
+typedef struct {
+    uint32_t row;
+    uint32_t col;
+    const char *levels; // one char per scan, '1' reads pressed, '0' reads released
+} key_trace_t;
+
+typedef struct {
+    uint32_t tick;
+    uint32_t row;
+    uint32_t col;
+    bool pressed;
+} recorded_edge_t;
+
+typedef struct {
+    uint32_t tick;
+    size_t nr_edges;
+    recorded_edge_t edges[TEST_MAX_EDGES];
+} edge_recorder_t;
+
+static void record_edge(uint32_t row, uint32_t col, bool pressed, void *user_ctx)
+{
+    edge_recorder_t *recorder = (edge_recorder_t *)user_ctx;
+    TEST_ASSERT_LESS_THAN(TEST_MAX_EDGES, recorder->nr_edges);
+    recorder->edges[recorder->nr_edges++] = (recorded_edge_t) {
+        .tick = recorder->tick,
+        .row = row,
+        .col = col,
+        .pressed = pressed,
+    };
+}
+
+// Feed synthetic bounce traces, scan by scan, and return whether the debouncer still wants to be scanned after the last one
+static bool play_traces(matrix_kbd_debounce_t *debounce, const key_trace_t *traces, size_t nr_traces, edge_recorder_t *recorder)
+{
+    size_t len = strlen(traces[0].levels);
+    bool busy = false;
+    for (size_t tick = 0; tick < len; tick++) {
+        uint32_t raw_rows[TEST_ROWS] = {0};
+        for (size_t i = 0; i < nr_traces; i++) {
+            TEST_ASSERT_EQUAL(len, strlen(traces[i].levels));
+            if (traces[i].levels[tick] == '1') {
+                raw_rows[traces[i].row] |= 1 << traces[i].col;
+            }
+        }
+        recorder->tick = tick;
+        busy = matrix_kbd_debounce_update(debounce, raw_rows, record_edge, recorder);
+    }
+    return busy;
+}
+
+static void assert_edge(const recorded_edge_t *edge, uint32_t tick, uint32_t row, uint32_t col, bool pressed)
+{
+    TEST_ASSERT_EQUAL_UINT32(tick, edge->tick);
+    TEST_ASSERT_EQUAL_UINT32(row, edge->row);
+    TEST_ASSERT_EQUAL_UINT32(col, edge->col);
+    TEST_ASSERT_EQUAL(pressed, edge->pressed);
+}
+
+TEST_CASE("debounce clean press and release", "[mkbd]")
+{
+    matrix_kbd_debounce_t *debounce = NULL;
+    TEST_ESP_OK(matrix_kbd_debounce_new(TEST_ROWS, TEST_COLS, 5, &debounce));
+    edge_recorder_t recorder = {0};
+    key_trace_t trace = { .row = 1, .col = 2, .levels = "0111111111000000" };
+
+    TEST_ASSERT_FALSE(play_traces(debounce, &trace, 1, &recorder));
+    TEST_ASSERT_EQUAL(2, recorder.nr_edges);
+    // pressed on the 5th pressed scan, released once the integrator drains back to zero
+    assert_edge(&recorder.edges[0], 5, 1, 2, true);
+    assert_edge(&recorder.edges[1], 14, 1, 2, false);
+    matrix_kbd_debounce_del(debounce);
+}
+
+TEST_CASE("debounce bounce bursts produce a single press and release", "[mkbd]")
+{
+    matrix_kbd_debounce_t *debounce = NULL;
+    TEST_ESP_OK(matrix_kbd_debounce_new(TEST_ROWS, TEST_COLS, 4, &debounce));
+    edge_recorder_t recorder = {0};
+    key_trace_t trace = { .row = 0, .col = 0, .levels = "0101101101111111111110101001000000000" };
+
+    TEST_ASSERT_FALSE(play_traces(debounce, &trace, 1, &recorder));
+    TEST_ASSERT_EQUAL(2, recorder.nr_edges);
+    TEST_ASSERT_TRUE(recorder.edges[0].pressed);
+    TEST_ASSERT_FALSE(recorder.edges[1].pressed);
+    matrix_kbd_debounce_del(debounce);
+}
+
+TEST_CASE("debounce rejects short glitches", "[mkbd]")
+{
+    matrix_kbd_debounce_t *debounce = NULL;
+    TEST_ESP_OK(matrix_kbd_debounce_new(TEST_ROWS, TEST_COLS, 3, &debounce));
+    edge_recorder_t recorder = {0};
+    key_trace_t trace = { .row = 3, .col = 3, .levels = "000100011000010100000" };
+
+    TEST_ASSERT_FALSE(play_traces(debounce, &trace, 1, &recorder));
+    TEST_ASSERT_EQUAL(0, recorder.nr_edges);
+    matrix_kbd_debounce_del(debounce);
+}
+
+TEST_CASE("debounce resolves simultaneous keys independently", "[mkbd]")
+{
+    matrix_kbd_debounce_t *debounce = NULL;
+    TEST_ESP_OK(matrix_kbd_debounce_new(TEST_ROWS, TEST_COLS, 3, &debounce));
+    edge_recorder_t recorder = {0};
+    key_trace_t traces[] = {
+        // bounces for a long time, must not delay its neighbours
+        { .row = 2, .col = 0, .levels = "010101011111100000000" },
+        // same row, clean press during the bounce
+        { .row = 2, .col = 1, .levels = "001111111111111111100" },
+        // other row, pressed while both others are held
+        { .row = 0, .col = 3, .levels = "000000000111111000000" },
+    };
+
+    play_traces(debounce, traces, 3, &recorder);
+    TEST_ASSERT_EQUAL(5, recorder.nr_edges);
+    assert_edge(&recorder.edges[0], 4, 2, 1, true);
+    assert_edge(&recorder.edges[1], 9, 2, 0, true);
+    assert_edge(&recorder.edges[2], 11, 0, 3, true);
+    assert_edge(&recorder.edges[3], 15, 2, 0, false);
+    assert_edge(&recorder.edges[4], 17, 0, 3, false);
+    // col 1 of row 2 is still held
+    TEST_ASSERT_EQUAL_HEX32(1 << 1, matrix_kbd_debounce_get_state(debounce)[2]);
+    matrix_kbd_debounce_del(debounce);
+}
+
+TEST_CASE("debounce worst case latency is bounded", "[mkbd]")
+{
+    const uint32_t threshold = 5;
+    const uint32_t max_bounce = 12;
+    uint32_t seed = 0x1234567;
+    matrix_kbd_debounce_t *debounce = NULL;
+    TEST_ESP_OK(matrix_kbd_debounce_new(TEST_ROWS, TEST_COLS, threshold, &debounce));
+
+    for (int run = 0; run < 200; run++) {
+        char levels[64] = {0};
+        // random bounce of up to max_bounce scans, then held for long enough
+        for (uint32_t tick = 0; tick < max_bounce; tick++) {
+            seed = seed * 1103515245 + 12345;
+            levels[tick] = (seed >> 16) & 1 ? '1' : '0';
+        }
+        memset(levels + max_bounce, '1', threshold + 1);
+        key_trace_t trace = { .row = run % TEST_ROWS, .col = (run / TEST_ROWS) % TEST_COLS, .levels = levels };
+        edge_recorder_t recorder = {0};
+
+        matrix_kbd_debounce_reset(debounce);
+        play_traces(debounce, &trace, 1, &recorder);
+        TEST_ASSERT_GREATER_OR_EQUAL(1, recorder.nr_edges);
+        TEST_ASSERT_TRUE(recorder.edges[0].pressed);
+        TEST_ASSERT_LESS_THAN(max_bounce + threshold, recorder.edges[0].tick);
+    }
+    matrix_kbd_debounce_del(debounce);
+}
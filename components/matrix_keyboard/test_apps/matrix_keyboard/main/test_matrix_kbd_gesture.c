@@ -0,0 +1,215 @@
+/*
+ * SPDX-FileCopyrightText: 2020-2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include "unity.h"
+#include "esp_private/matrix_kbd_gesture.h"
+
+#define TEST_ROWS 4
+#define TEST_COLS 4
+#define TEST_MAX_GESTURES 32
+
+typedef struct {
+    matrix_kbd_event_id_t id;
+    uint32_t time_ms;
+    uint32_t nr_keys;
+    uint32_t key_codes[MATRIX_KBD_CHORD_MAX_KEYS];
+} recorded_gesture_t;
+
+typedef struct {
+    uint32_t now_ms;
+    size_t nr_gestures;
+    recorded_gesture_t gestures[TEST_MAX_GESTURES];
+} gesture_recorder_t;
+
+static void record_gesture(matrix_kbd_event_id_t id, const uint32_t *key_codes, uint32_t nr_keys, void *user_ctx)
+{
+    gesture_recorder_t *recorder = (gesture_recorder_t *)user_ctx;
+    TEST_ASSERT_LESS_THAN(TEST_MAX_GESTURES, recorder->nr_gestures);
+    recorded_gesture_t *gesture = &recorder->gestures[recorder->nr_gestures++];
+    gesture->id = id;
+    gesture->time_ms = recorder->now_ms;
+    gesture->nr_keys = nr_keys;
+    for (uint32_t i = 0; i < nr_keys; i++) {
+        gesture->key_codes[i] = key_codes[i];
+    }
+}
+
+// Tick the engine every millisecond up to `until_ms`, like the scan timer does while keys are held
+static void run_until(matrix_kbd_gesture_t *gesture, gesture_recorder_t *recorder, uint32_t until_ms)
+{
+    while (recorder->now_ms < until_ms) {
+        recorder->now_ms++;
+        matrix_kbd_gesture_tick(gesture, recorder->now_ms, record_gesture, recorder);
+    }
+}
+
+static void key(matrix_kbd_gesture_t *gesture, gesture_recorder_t *recorder, uint32_t row, uint32_t col, bool pressed)
+{
+    matrix_kbd_gesture_on_key(gesture, row, col, pressed, recorder->now_ms, record_gesture, recorder);
+}
+
+static matrix_kbd_gesture_t *new_gesture(uint32_t long_press_ms, uint32_t repeat_interval_ms, uint32_t double_tap_ms, uint32_t chord_window_ms)
+{
+    matrix_kbd_gesture_config_t config = {
+        .long_press_ms = long_press_ms,
+        .repeat_interval_ms = repeat_interval_ms,
+        .double_tap_ms = double_tap_ms,
+        .chord_window_ms = chord_window_ms,
+    };
+    matrix_kbd_gesture_t *gesture = NULL;
+    TEST_ESP_OK(matrix_kbd_gesture_new(TEST_ROWS, TEST_COLS, &config, &gesture));
+    return gesture;
+}
+
+TEST_CASE("gesture long press then repeat", "[mkbd]")
+{
+    matrix_kbd_gesture_t *gesture = new_gesture(500, 100, 0, 0);
+    gesture_recorder_t recorder = {0};
+
+    key(gesture, &recorder, 1, 2, true);
+    run_until(gesture, &recorder, 499);
+    TEST_ASSERT_EQUAL(0, recorder.nr_gestures);
+    run_until(gesture, &recorder, 750);
+    key(gesture, &recorder, 1, 2, false);
+    run_until(gesture, &recorder, 1000);
+
+    TEST_ASSERT_EQUAL(3, recorder.nr_gestures);
+    TEST_ASSERT_EQUAL(MATRIX_KBD_EVENT_LONG_PRESS, recorder.gestures[0].id);
+    TEST_ASSERT_EQUAL_UINT32(500, recorder.gestures[0].time_ms);
+    TEST_ASSERT_EQUAL_HEX32(MAKE_KEY_CODE(1, 2), recorder.gestures[0].key_codes[0]);
+    TEST_ASSERT_EQUAL(MATRIX_KBD_EVENT_REPEAT, recorder.gestures[1].id);
+    TEST_ASSERT_EQUAL_UINT32(600, recorder.gestures[1].time_ms);
+    TEST_ASSERT_EQUAL(MATRIX_KBD_EVENT_REPEAT, recorder.gestures[2].id);
+    TEST_ASSERT_EQUAL_UINT32(700, recorder.gestures[2].time_ms);
+    matrix_kbd_gesture_del(gesture);
+}
+
+TEST_CASE("gesture repeats don't drift with a coarse tick", "[mkbd]")
+{
+    matrix_kbd_gesture_t *gesture = new_gesture(300, 50, 0, 0);
+    gesture_recorder_t recorder = {0};
+
+    key(gesture, &recorder, 0, 0, true);
+    // tick every 7 ms, repeats are still chained from their deadline
+    for (uint32_t now = 7; now <= 1001; now += 7) {
+        recorder.now_ms = now;
+        matrix_kbd_gesture_tick(gesture, now, record_gesture, &recorder);
+    }
+    // long press at 300, repeats at 350, 400 ... 1000
+    TEST_ASSERT_EQUAL(1 + 14, recorder.nr_gestures);
+    matrix_kbd_gesture_del(gesture);
+}
+
+TEST_CASE("gesture double tap", "[mkbd]")
+{
+    matrix_kbd_gesture_t *gesture = new_gesture(500, 0, 200, 0);
+    gesture_recorder_t recorder = {0};
+
+    key(gesture, &recorder, 3, 1, true);
+    run_until(gesture, &recorder, 80);
+    key(gesture, &recorder, 3, 1, false);
+    run_until(gesture, &recorder, 250);
+    key(gesture, &recorder, 3, 1, true);
+    run_until(gesture, &recorder, 300);
+    key(gesture, &recorder, 3, 1, false);
+    // a third tap doesn't make another double tap
+    run_until(gesture, &recorder, 350);
+    key(gesture, &recorder, 3, 1, true);
+    run_until(gesture, &recorder, 400);
+    key(gesture, &recorder, 3, 1, false);
+
+    TEST_ASSERT_EQUAL(1, recorder.nr_gestures);
+    TEST_ASSERT_EQUAL(MATRIX_KBD_EVENT_DOUBLE_TAP, recorder.gestures[0].id);
+    TEST_ASSERT_EQUAL_UINT32(250, recorder.gestures[0].time_ms);
+    matrix_kbd_gesture_del(gesture);
+}
+
+TEST_CASE("gesture double tap window expires while idle", "[mkbd]")
+{
+    matrix_kbd_gesture_t *gesture = new_gesture(0, 0, 200, 0);
+    gesture_recorder_t recorder = {0};
+
+    key(gesture, &recorder, 0, 3, true);
+    run_until(gesture, &recorder, 50);
+    key(gesture, &recorder, 0, 3, false);
+    // no tick while idle, the expired window is caught up on the next edge
+    recorder.now_ms = 5000;
+    key(gesture, &recorder, 0, 3, true);
+    run_until(gesture, &recorder, 5100);
+    key(gesture, &recorder, 0, 3, false);
+
+    TEST_ASSERT_EQUAL(0, recorder.nr_gestures);
+    matrix_kbd_gesture_del(gesture);
+}
+
+TEST_CASE("gesture chord of held keys", "[mkbd]")
+{
+    matrix_kbd_gesture_t *gesture = new_gesture(0, 0, 0, 50);
+    gesture_recorder_t recorder = {0};
+
+    key(gesture, &recorder, 3, 0, true);
+    run_until(gesture, &recorder, 20);
+    key(gesture, &recorder, 3, 3, true);
+    run_until(gesture, &recorder, 200);
+    key(gesture, &recorder, 3, 0, false);
+    key(gesture, &recorder, 3, 3, false);
+
+    TEST_ASSERT_EQUAL(1, recorder.nr_gestures);
+    TEST_ASSERT_EQUAL(MATRIX_KBD_EVENT_CHORD, recorder.gestures[0].id);
+    TEST_ASSERT_EQUAL_UINT32(50, recorder.gestures[0].time_ms);
+    TEST_ASSERT_EQUAL_UINT32(2, recorder.gestures[0].nr_keys);
+    TEST_ASSERT_EQUAL_HEX32(MAKE_KEY_CODE(3, 0), recorder.gestures[0].key_codes[0]);
+    TEST_ASSERT_EQUAL_HEX32(MAKE_KEY_CODE(3, 3), recorder.gestures[0].key_codes[1]);
+    matrix_kbd_gesture_del(gesture);
+}
+
+TEST_CASE("gesture chord of too many keys is dropped", "[mkbd]")
+{
+    matrix_kbd_gesture_t *gesture = new_gesture(0, 0, 0, 50);
+    gesture_recorder_t recorder = {0};
+
+    // one key more than a chord holds, all within the window
+    for (uint32_t i = 0; i <= MATRIX_KBD_CHORD_MAX_KEYS; i++) {
+        key(gesture, &recorder, i / TEST_COLS, i % TEST_COLS, true);
+        run_until(gesture, &recorder, recorder.now_ms + 5);
+    }
+    run_until(gesture, &recorder, 200);
+    TEST_ASSERT_EQUAL(0, recorder.nr_gestures);
+    for (uint32_t i = 0; i <= MATRIX_KBD_CHORD_MAX_KEYS; i++) {
+        key(gesture, &recorder, i / TEST_COLS, i % TEST_COLS, false);
+    }
+
+    // the next window starts afresh
+    key(gesture, &recorder, 3, 0, true);
+    key(gesture, &recorder, 3, 1, true);
+    run_until(gesture, &recorder, 300);
+
+    TEST_ASSERT_EQUAL(1, recorder.nr_gestures);
+    TEST_ASSERT_EQUAL(MATRIX_KBD_EVENT_CHORD, recorder.gestures[0].id);
+    TEST_ASSERT_EQUAL_UINT32(2, recorder.gestures[0].nr_keys);
+    matrix_kbd_gesture_del(gesture);
+}
+
+TEST_CASE("gesture chord cancelled by an early release", "[mkbd]")
+{
+    matrix_kbd_gesture_t *gesture = new_gesture(0, 0, 0, 50);
+    gesture_recorder_t recorder = {0};
+
+    key(gesture, &recorder, 1, 1, true);
+    run_until(gesture, &recorder, 10);
+    key(gesture, &recorder, 2, 2, true);
+    run_until(gesture, &recorder, 30);
+    key(gesture, &recorder, 1, 1, false);
+    run_until(gesture, &recorder, 200);
+    // keys pressed one after another, further apart than the window
+    key(gesture, &recorder, 0, 0, true);
+    run_until(gesture, &recorder, 300);
+    key(gesture, &recorder, 0, 1, true);
+    run_until(gesture, &recorder, 400);
+
+    TEST_ASSERT_EQUAL(0, recorder.nr_gestures);
+    matrix_kbd_gesture_del(gesture);
+}
@@ -0,0 +1,51 @@
+/*
+ * SPDX-FileCopyrightText: 2020-2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include "unity.h"
+#include "esp_private/matrix_kbd_ghost.h"
+
+#define TEST_ROWS 4
+
+TEST_CASE("ghost two keys sharing a row or a column are not ambiguous", "[mkbd]")
+{
+    uint32_t ambiguous[TEST_ROWS];
+    const uint32_t same_row[TEST_ROWS] = {0x3, 0, 0, 0};
+    const uint32_t same_col[TEST_ROWS] = {0x4, 0x4, 0, 0};
+    const uint32_t l_shape[TEST_ROWS] = {0x3, 0x1, 0, 0};
+
+    TEST_ASSERT_FALSE(matrix_kbd_ghost_detect(same_row, TEST_ROWS, ambiguous));
+    TEST_ASSERT_FALSE(matrix_kbd_ghost_detect(same_col, TEST_ROWS, ambiguous));
+    TEST_ASSERT_FALSE(matrix_kbd_ghost_detect(l_shape, TEST_ROWS, ambiguous));
+    TEST_ASSERT_EACH_EQUAL_HEX32(0, ambiguous, TEST_ROWS);
+}
+
+TEST_CASE("ghost rectangle corners are ambiguous", "[mkbd]")
+{
+    uint32_t ambiguous[TEST_ROWS];
+    // keys (0,1) (0,3) (2,1) pressed, (2,3) reads pressed through them, (3,0) is unrelated
+    const uint32_t raw[TEST_ROWS] = {0xA, 0, 0xA, 0x1};
+
+    TEST_ASSERT_TRUE(matrix_kbd_ghost_detect(raw, TEST_ROWS, ambiguous));
+    TEST_ASSERT_EQUAL_HEX32(0xA, ambiguous[0]);
+    TEST_ASSERT_EQUAL_HEX32(0, ambiguous[1]);
+    TEST_ASSERT_EQUAL_HEX32(0xA, ambiguous[2]);
+    TEST_ASSERT_EQUAL_HEX32(0, ambiguous[3]);
+}
+
+TEST_CASE("ghost blocking keeps the previous state of ambiguous keys", "[mkbd]")
+{
+    uint32_t ambiguous[TEST_ROWS];
+    // (0,0) (0,1) (1,0) were already held, (1,1) now reads pressed, (3,2) is a genuine new press
+    const uint32_t stable[TEST_ROWS] = {0x3, 0x1, 0, 0};
+    uint32_t raw[TEST_ROWS] = {0x3, 0x3, 0, 0x4};
+
+    TEST_ASSERT_TRUE(matrix_kbd_ghost_detect(raw, TEST_ROWS, ambiguous));
+    matrix_kbd_ghost_block(raw, stable, ambiguous, TEST_ROWS);
+    TEST_ASSERT_EQUAL_HEX32(0x3, raw[0]);
+    TEST_ASSERT_EQUAL_HEX32(0x1, raw[1]);
+    TEST_ASSERT_EQUAL_HEX32(0, raw[2]);
+    TEST_ASSERT_EQUAL_HEX32(0x4, raw[3]);
+}
@@ -0,0 +1,86 @@
+/*
+ * SPDX-FileCopyrightText: 2020-2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include "unity.h"
+#include "esp_private/matrix_kbd_listener.h"
+
+static esp_err_t handler_a(matrix_kbd_handle_t mkbd_handle, matrix_kbd_event_id_t event, void *event_data, void *handler_args)
+{
+    return ESP_OK;
+}
+
+static esp_err_t handler_b(matrix_kbd_handle_t mkbd_handle, matrix_kbd_event_id_t event, void *event_data, void *handler_args)
+{
+    return ESP_OK;
+}
+
+TEST_CASE("listener receives only the events in its mask", "[mkbd]")
+{
+    matrix_kbd_listeners_t listeners = {0};
+    TEST_ASSERT_FALSE(matrix_kbd_listeners_want(&listeners, MATRIX_KBD_EVENT_DOWN));
+
+    int down = matrix_kbd_listeners_add(&listeners, MATRIX_KBD_EVENT_MASK(MATRIX_KBD_EVENT_DOWN), handler_a, NULL);
+    int chord = matrix_kbd_listeners_add(&listeners, MATRIX_KBD_EVENT_MASK(MATRIX_KBD_EVENT_CHORD), handler_b, NULL);
+    TEST_ASSERT_EQUAL(1, down);
+    TEST_ASSERT_EQUAL(2, chord);
+
+    TEST_ASSERT_TRUE(matrix_kbd_listener_wants(&listeners.slots[down], MATRIX_KBD_EVENT_DOWN));
+    TEST_ASSERT_FALSE(matrix_kbd_listener_wants(&listeners.slots[down], MATRIX_KBD_EVENT_UP));
+    TEST_ASSERT_FALSE(matrix_kbd_listener_wants(&listeners.slots[down], MATRIX_KBD_EVENT_CHORD));
+    TEST_ASSERT_TRUE(matrix_kbd_listener_wants(&listeners.slots[chord], MATRIX_KBD_EVENT_CHORD));
+    TEST_ASSERT_FALSE(matrix_kbd_listener_wants(&listeners.slots[chord], MATRIX_KBD_EVENT_DOWN));
+    // free slots never match, whatever the event
+    TEST_ASSERT_FALSE(matrix_kbd_listener_wants(&listeners.slots[0], MATRIX_KBD_EVENT_DOWN));
+    TEST_ASSERT_FALSE(matrix_kbd_listener_wants(&listeners.slots[3], MATRIX_KBD_EVENT_DOWN));
+
+    // the union drives the scan tick, events nobody listens to are never queued
+    TEST_ASSERT_TRUE(matrix_kbd_listeners_want(&listeners, MATRIX_KBD_EVENT_DOWN));
+    TEST_ASSERT_TRUE(matrix_kbd_listeners_want(&listeners, MATRIX_KBD_EVENT_CHORD));
+    TEST_ASSERT_FALSE(matrix_kbd_listeners_want(&listeners, MATRIX_KBD_EVENT_UP));
+    TEST_ASSERT_FALSE(matrix_kbd_listeners_want(&listeners, MATRIX_KBD_EVENT_REPEAT));
+
+    // the register_event_handler slot receives everything
+    matrix_kbd_listeners_set(&listeners, 0, MATRIX_KBD_EVENT_MASK_ALL, handler_a, NULL);
+    TEST_ASSERT_TRUE(matrix_kbd_listener_wants(&listeners.slots[0], MATRIX_KBD_EVENT_UP));
+    TEST_ASSERT_TRUE(matrix_kbd_listeners_want(&listeners, MATRIX_KBD_EVENT_REPEAT));
+    matrix_kbd_listeners_set(&listeners, 0, MATRIX_KBD_EVENT_MASK_ALL, NULL, NULL);
+    TEST_ASSERT_FALSE(matrix_kbd_listeners_want(&listeners, MATRIX_KBD_EVENT_UP));
+}
+
+TEST_CASE("listener removal drops its events from the union", "[mkbd]")
+{
+    int arg = 0;
+    matrix_kbd_listeners_t listeners = {0};
+    uint32_t mask = MATRIX_KBD_EVENT_MASK(MATRIX_KBD_EVENT_DOWN) | MATRIX_KBD_EVENT_MASK(MATRIX_KBD_EVENT_UP);
+
+    TEST_ASSERT_EQUAL(1, matrix_kbd_listeners_add(&listeners, mask, handler_a, NULL));
+    TEST_ASSERT_EQUAL(2, matrix_kbd_listeners_add(&listeners, MATRIX_KBD_EVENT_MASK(MATRIX_KBD_EVENT_UP), handler_a, &arg));
+
+    // handler and argument must both match
+    TEST_ASSERT_EQUAL(0, matrix_kbd_listeners_remove(&listeners, handler_b, NULL));
+    TEST_ASSERT_EQUAL(1, matrix_kbd_listeners_remove(&listeners, handler_a, NULL));
+    TEST_ASSERT_EQUAL(0, matrix_kbd_listeners_remove(&listeners, handler_a, NULL));
+    TEST_ASSERT_FALSE(matrix_kbd_listeners_want(&listeners, MATRIX_KBD_EVENT_DOWN));
+    TEST_ASSERT_TRUE(matrix_kbd_listeners_want(&listeners, MATRIX_KBD_EVENT_UP));
+
+    // the freed slot is reused before the later ones
+    TEST_ASSERT_EQUAL(1, matrix_kbd_listeners_add(&listeners, mask, handler_b, NULL));
+    TEST_ASSERT_EQUAL(2, matrix_kbd_listeners_remove(&listeners, handler_a, &arg));
+    TEST_ASSERT_TRUE(matrix_kbd_listeners_want(&listeners, MATRIX_KBD_EVENT_UP));
+    TEST_ASSERT_EQUAL(1, matrix_kbd_listeners_remove(&listeners, handler_b, NULL));
+    TEST_ASSERT_FALSE(matrix_kbd_listeners_want(&listeners, MATRIX_KBD_EVENT_UP));
+}
+
+TEST_CASE("listener slots run out after MATRIX_KBD_MAX_LISTENERS", "[mkbd]")
+{
+    matrix_kbd_listeners_t listeners = {0};
+    for (int i = 0; i < MATRIX_KBD_MAX_LISTENERS; i++) {
+        TEST_ASSERT_EQUAL(i + 1, matrix_kbd_listeners_add(&listeners, MATRIX_KBD_EVENT_MASK_ALL, handler_a, NULL));
+    }
+    TEST_ASSERT_EQUAL(0, matrix_kbd_listeners_add(&listeners, MATRIX_KBD_EVENT_MASK_ALL, handler_b, NULL));
+    // slot 0 belongs to register_event_handler and is never taken by add
+    TEST_ASSERT_NULL(listeners.slots[0].handler);
+}
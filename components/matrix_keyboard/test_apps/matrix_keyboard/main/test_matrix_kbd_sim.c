@@ -0,0 +1,191 @@
+/*
+ * SPDX-FileCopyrightText: 2020-2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include <stdio.h>
+#include <inttypes.h>
+#include "unity.h"
+#include "mkbd_sim.h"
+
+#define TEST_SCAN_INTERVAL_US 1000
+#define TEST_DEBOUNCE_SCANS   5
+#define TEST_BOUNCE_US        3000
+
+static void sim_init(mkbd_sim_t *sim, uint32_t nr_rows, uint32_t nr_cols, bool ghosting)
+{
+    *sim = (mkbd_sim_t) {
+        .nr_rows = nr_rows,
+        .nr_cols = nr_cols,
+        .scan_interval_us = TEST_SCAN_INTERVAL_US,
+        .ghosting = ghosting,
+        .seed = 0x5EED,
+    };
+}
+
+static bool sim_has_key_event(const mkbd_sim_t *sim, matrix_kbd_event_id_t id, uint32_t row, uint32_t col)
+{
+    for (size_t i = 0; i < sim->nr_events; i++) {
+        if (sim->events[i].id == id && sim->events[i].data.key_code == MAKE_KEY_CODE(row, col)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+TEST_CASE("sim bounce bursts report one down and one up per press", "[mkbd]")
+{
+    mkbd_sim_t sim;
+    matrix_kbd_core_config_t config = {
+        .debounce_threshold = TEST_DEBOUNCE_SCANS,
+        .ghost_mode = MATRIX_KBD_GHOST_BLOCK,
+    };
+    sim_init(&sim, 4, 4, false);
+    mkbd_sim_add_key(&sim, 1, 2, 10000, 60000, TEST_BOUNCE_US);
+    mkbd_sim_add_key(&sim, 1, 2, 100000, 150000, TEST_BOUNCE_US);
+    mkbd_sim_add_key(&sim, 3, 0, 200000, 212000, TEST_BOUNCE_US);
+    mkbd_sim_run(&sim, &config, 300000);
+
+    TEST_ASSERT_EQUAL(6, sim.nr_events);
+    for (size_t i = 0; i < sim.nr_events; i++) {
+        const mkbd_sim_key_t *key = &sim.keys[i / 2];
+        const mkbd_sim_event_t *event = &sim.events[i];
+        int64_t edge_us = (i % 2) ? key->release_us : key->press_us;
+        TEST_ASSERT_EQUAL((i % 2) ? MATRIX_KBD_EVENT_UP : MATRIX_KBD_EVENT_DOWN, event->id);
+        TEST_ASSERT_EQUAL_HEX32(MAKE_KEY_CODE(key->row, key->col), event->data.key_code);
+        // reported once the burst is over and the key read steady for the debounce time
+        TEST_ASSERT_GREATER_OR_EQUAL(edge_us, event->data.timestamp_us);
+        TEST_ASSERT_LESS_THAN(edge_us + TEST_BOUNCE_US + (TEST_DEBOUNCE_SCANS + 1) * TEST_SCAN_INTERVAL_US, event->data.timestamp_us);
+    }
+}
+
+TEST_CASE("sim bounce shorter than the debounce time never reaches the event stream", "[mkbd]")
+{
+    mkbd_sim_t sim;
+    matrix_kbd_core_config_t config = {
+        .debounce_threshold = TEST_DEBOUNCE_SCANS,
+        .ghost_mode = MATRIX_KBD_GHOST_BLOCK,
+    };
+    sim_init(&sim, 4, 4, false);
+    // a brushed key: a burst of bounces, then open again
+    mkbd_sim_add_key(&sim, 2, 2, 10000, 10000 + TEST_BOUNCE_US, 0);
+    mkbd_sim_add_key(&sim, 0, 1, 50000, 50000, TEST_BOUNCE_US);
+    mkbd_sim_run(&sim, &config, 100000);
+
+    TEST_ASSERT_EQUAL(0, sim.nr_events);
+}
+
+TEST_CASE("sim chord of bouncing keys", "[mkbd]")
+{
+    mkbd_sim_t sim;
+    matrix_kbd_core_config_t config = {
+        .debounce_threshold = TEST_DEBOUNCE_SCANS,
+        .ghost_mode = MATRIX_KBD_GHOST_BLOCK,
+        .gesture = {
+            .chord_window_ms = 50,
+        },
+    };
+    sim_init(&sim, 4, 4, false);
+    mkbd_sim_add_key(&sim, 0, 1, 10000, 200000, TEST_BOUNCE_US);
+    mkbd_sim_add_key(&sim, 2, 3, 25000, 210000, TEST_BOUNCE_US);
+    mkbd_sim_run(&sim, &config, 300000);
+
+    TEST_ASSERT_EQUAL(5, sim.nr_events);
+    TEST_ASSERT_EQUAL(MATRIX_KBD_EVENT_DOWN, sim.events[0].id);
+    TEST_ASSERT_EQUAL(MATRIX_KBD_EVENT_DOWN, sim.events[1].id);
+    TEST_ASSERT_EQUAL(MATRIX_KBD_EVENT_CHORD, sim.events[2].id);
+    TEST_ASSERT_EQUAL_UINT32(2, sim.events[2].data.nr_chord_keys);
+    TEST_ASSERT_EQUAL_HEX32(MAKE_KEY_CODE(0, 1), sim.events[2].data.chord_key_codes[0]);
+    TEST_ASSERT_EQUAL_HEX32(MAKE_KEY_CODE(2, 3), sim.events[2].data.chord_key_codes[1]);
+    // the window opens on the first debounced key down
+    TEST_ASSERT_EQUAL(sim.events[0].data.timestamp_us + 50000, sim.events[2].data.timestamp_us);
+    TEST_ASSERT_EQUAL(MATRIX_KBD_EVENT_UP, sim.events[3].id);
+    TEST_ASSERT_EQUAL(MATRIX_KBD_EVENT_UP, sim.events[4].id);
+}
+
+TEST_CASE("sim ghost of a diode-less matrix is blocked", "[mkbd]")
+{
+    mkbd_sim_t sim;
+    matrix_kbd_core_config_t config = {
+        .debounce_threshold = TEST_DEBOUNCE_SCANS,
+        .ghost_mode = MATRIX_KBD_GHOST_BLOCK,
+    };
+    sim_init(&sim, 4, 4, true);
+    // three corners of a rectangle, (1,1) reads pressed while they are all down
+    mkbd_sim_add_key(&sim, 0, 0, 10000, 150000, 2000);
+    mkbd_sim_add_key(&sim, 0, 1, 30000, 100000, 2000);
+    mkbd_sim_add_key(&sim, 1, 0, 50000, 200000, 2000);
+    mkbd_sim_run(&sim, &config, 300000);
+
+    TEST_ASSERT_FALSE(sim_has_key_event(&sim, MATRIX_KBD_EVENT_DOWN, 1, 1));
+    // (1,0) can't be told from the ghost either, it's reported once the rectangle is broken
+    TEST_ASSERT_EQUAL(6, sim.nr_events);
+    TEST_ASSERT_EQUAL(MATRIX_KBD_EVENT_DOWN, sim.events[0].id);
+    TEST_ASSERT_EQUAL(MATRIX_KBD_EVENT_DOWN, sim.events[1].id);
+    TEST_ASSERT_EQUAL(MATRIX_KBD_EVENT_UP, sim.events[2].id);
+    TEST_ASSERT_EQUAL_HEX32(MAKE_KEY_CODE(0, 1), sim.events[2].data.key_code);
+    TEST_ASSERT_EQUAL(MATRIX_KBD_EVENT_DOWN, sim.events[3].id);
+    TEST_ASSERT_EQUAL_HEX32(MAKE_KEY_CODE(1, 0), sim.events[3].data.key_code);
+    TEST_ASSERT_GREATER_OR_EQUAL(100000, sim.events[3].data.timestamp_us);
+    for (size_t i = 0; i < sim.nr_events; i++) {
+        TEST_ASSERT_FALSE(sim.events[i].data.ambiguous);
+    }
+}
+
+TEST_CASE("sim ghost of a diode-less matrix is flagged", "[mkbd]")
+{
+    mkbd_sim_t sim;
+    matrix_kbd_core_config_t config = {
+        .debounce_threshold = TEST_DEBOUNCE_SCANS,
+        .ghost_mode = MATRIX_KBD_GHOST_FLAG,
+    };
+    sim_init(&sim, 4, 4, true);
+    mkbd_sim_add_key(&sim, 0, 0, 10000, 150000, 2000);
+    mkbd_sim_add_key(&sim, 0, 1, 30000, 100000, 2000);
+    mkbd_sim_add_key(&sim, 1, 0, 50000, 200000, 2000);
+    mkbd_sim_run(&sim, &config, 300000);
+
+    TEST_ASSERT_TRUE(sim_has_key_event(&sim, MATRIX_KBD_EVENT_DOWN, 1, 1));
+    for (size_t i = 0; i < sim.nr_events; i++) {
+        uint32_t code = sim.events[i].data.key_code;
+        if (sim.events[i].id == MATRIX_KBD_EVENT_DOWN && GET_KEY_CODE_ROW(code) == 1) {
+            TEST_ASSERT_TRUE(sim.events[i].data.ambiguous);
+        }
+    }
+}
+
+TEST_CASE("sim detection latency and scan cost", "[mkbd][bench]")
+{
+    static const struct {
+        uint32_t nr_rows;
+        uint32_t nr_cols;
+    } sizes[] = {{4, 4}, {8, 8}, {16, 16}, {16, 32}};
+    matrix_kbd_core_config_t config = {
+        .debounce_threshold = TEST_DEBOUNCE_SCANS,
+        .ghost_mode = MATRIX_KBD_GHOST_BLOCK,
+    };
+
+    printf("%-7s %8s %10s %10s %10s\n", "matrix", "events", "avg lat us", "max lat us", "ns/scan");
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        mkbd_sim_t sim;
+        sim_init(&sim, sizes[s].nr_rows, sizes[s].nr_cols, false);
+        // keys spread over the matrix, pressed one after another with a 2 ms burst
+        for (uint32_t i = 0; i < MKBD_SIM_MAX_KEYS; i++) {
+            int64_t press_us = 20000 + i * 60000 + i * 137;
+            mkbd_sim_add_key(&sim, (i * 5) % sim.nr_rows, (i * 7) % sim.nr_cols, press_us, press_us + 30000, 2000);
+        }
+        mkbd_sim_run(&sim, &config, 1000000);
+
+        TEST_ASSERT_EQUAL(2 * MKBD_SIM_MAX_KEYS, sim.nr_events);
+        int64_t total_us = 0;
+        int64_t max_us = 0;
+        for (size_t i = 0; i < sim.nr_events; i += 2) {
+            int64_t latency_us = sim.events[i].data.timestamp_us - sim.keys[i / 2].press_us;
+            total_us += latency_us;
+            max_us = latency_us > max_us ? latency_us : max_us;
+        }
+        printf("%2"PRIu32"x%-4"PRIu32" %8zu %10"PRId64" %10"PRId64" %10"PRIu64"\n", sim.nr_rows, sim.nr_cols, sim.nr_events,
+               total_us / MKBD_SIM_MAX_KEYS, max_us, sim.scan_ns / sim.nr_scans);
+    }
+}
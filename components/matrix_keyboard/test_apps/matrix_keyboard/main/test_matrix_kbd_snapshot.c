@@ -0,0 +1,48 @@
+/*
+ * SPDX-FileCopyrightText: 2020-2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include "unity.h"
+#include "esp_private/matrix_kbd_snapshot.h"
+
+TEST_CASE("snapshot latch publish bumps the sequence once per copy", "[mkbd]")
+{
+    matrix_kbd_latch_t latch;
+    matrix_kbd_snapshot_t snapshot = {0};
+    matrix_kbd_latch_init(&latch);
+    TEST_ASSERT_EQUAL_UINT32(0, atomic_load(&latch.seq));
+
+    for (uint32_t i = 1; i <= 3; i++) {
+        snapshot.seq = i;
+        matrix_kbd_latch_publish(&latch, &snapshot);
+        // even again, readers are on copies[0] once both copies hold the new snapshot
+        TEST_ASSERT_EQUAL_UINT32(2 * i, atomic_load(&latch.seq));
+        TEST_ASSERT_EQUAL_UINT32(i, latch.copies[0].seq);
+        TEST_ASSERT_EQUAL_UINT32(i, latch.copies[1].seq);
+    }
+}
+
+TEST_CASE("snapshot latch read returns the latest publish", "[mkbd]")
+{
+    matrix_kbd_latch_t latch;
+    matrix_kbd_snapshot_t snapshot = {0};
+    matrix_kbd_snapshot_t out;
+    matrix_kbd_latch_init(&latch);
+
+    for (uint32_t i = 1; i <= 4; i++) {
+        snapshot.seq = i;
+        snapshot.scan_time_us = 1000 * i;
+        snapshot.keys[0] = 1U << i;
+        snapshot.keys[MATRIX_KBD_MAX_KEYS / 32 - 1] = ~(1U << i);
+        matrix_kbd_latch_publish(&latch, &snapshot);
+        // two reads in a row return the same snapshot, reading never changes the latch
+        for (int j = 0; j < 2; j++) {
+            matrix_kbd_latch_read(&latch, &out);
+            TEST_ASSERT_EQUAL_UINT32(i, out.seq);
+            TEST_ASSERT_EQUAL_INT64(1000 * i, out.scan_time_us);
+            TEST_ASSERT_EQUAL_HEX32_ARRAY(snapshot.keys, out.keys, MATRIX_KBD_MAX_KEYS / 32);
+        }
+    }
+}
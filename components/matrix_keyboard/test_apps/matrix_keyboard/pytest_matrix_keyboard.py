@@ -0,0 +1,10 @@
+# SPDX-FileCopyrightText: 2020-2023 Espressif Systems (Shanghai) CO LTD
+# SPDX-License-Identifier: CC0-1.0
+import pytest
+from pytest_embedded_idf import IdfDut
+
+
+@pytest.mark.linux
+@pytest.mark.host_test
+def test_matrix_keyboard(dut: IdfDut) -> None:
+    dut.run_all_single_board_cases()
@@ -0,0 +1,264 @@
+// -----------------------------------------------------------------------------------
+// Copyright 2024, Gilles Zunino
+// -----------------------------------------------------------------------------------
+
+#include "sdkconfig.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_check.h>
+
+#if CONFIG_IDF_TARGET_LINUX
+#include <time.h>
+#include "spi_master_mock.h"
+#else
+#include <esp_timer.h>
+#include <esp_cpu.h>
+#endif
+
+#include "max7219_7221.h"
+
+const char* TAG = "max72[19|21]_benchmark";
+
+//
+// NOTE: For maximum performance, prefer IO MUX over GPIO Matrix routing
+//
+
+// SPI Host ID
+const spi_host_device_t SPI_HOSTID = SPI2_HOST;
+
+// SPI pins - Depends on the chip and the board
+#if CONFIG_IDF_TARGET_ESP32
+const gpio_num_t CS_LOAD_PIN = GPIO_NUM_19;
+const gpio_num_t CLK_PIN = GPIO_NUM_18;
+const gpio_num_t DIN_PIN = GPIO_NUM_16;
+#else
+#if CONFIG_IDF_TARGET_ESP32S3
+const gpio_num_t CS_LOAD_PIN = GPIO_NUM_10;
+const gpio_num_t CLK_PIN = GPIO_NUM_12;
+const gpio_num_t DIN_PIN = GPIO_NUM_11;
+#else
+#if CONFIG_IDF_TARGET_LINUX
+// Pins are never touched by the mocked SPI master - /CS (LOAD) only needs to pass driver configuration checks
+const gpio_num_t CS_LOAD_PIN = (gpio_num_t) 10;
+#endif
+#endif
+#endif
+
+// Chain lengths to sweep - The driver does not read anything back so the physical chain can be shorter than the configured one
+const uint8_t ChainLengths[] = { 1, 2, 4, 8 };
+
+// SPI clock speeds to sweep - MAX7219 / MAX7221 support up to 10 MHz
+const int ClockSpeedsHz[] = { 1 * 1000000, 5 * 1000000, 10 * 1000000 };
+
+// Number of frames to send per measurement - A frame updates every digit on the chain
+const uint32_t FramesPerRun = 200;
+
+// Time given to the CPU load probe to measure how fast it spins when the CPU is otherwise idle
+const TickType_t ProbeCalibrationTime = pdMS_TO_TICKS(500);
+
+
+typedef enum {
+    BENCHMARK_API_SET_DIGIT = 0,    // One led_driver_max7219_set_digit() per digit on the chain
+    BENCHMARK_API_SET_DIGITS,       // One led_driver_max7219_set_digits() covering the whole chain (batch path)
+    BENCHMARK_API_SET_CHAIN,        // One led_driver_max7219_set_chain()
+    BENCHMARK_API_COUNT
+} benchmark_api_t;
+
+const char* const BenchmarkApiNames[BENCHMARK_API_COUNT] = { "set_digit", "set_digits", "set_chain" };
+
+typedef struct benchmark_result {
+    uint64_t elapsedUs;         // Wall clock time for all frames
+    uint64_t cycles;            // CPU cycles for all frames (0 when not available)
+    uint32_t cpuLoadPermille;   // CPU time spent by the benchmark task, in 1/1000th of the wall clock time
+} benchmark_result_t;
+
+
+
+#if !CONFIG_IDF_TARGET_LINUX
+//
+// CPU load probe - A busy loop at the lowest application priority counts iterations
+// Comparing its spin rate during a run with its spin rate on an idle CPU gives the share of CPU the benchmark used, including time spent in SPI interrupts
+//
+static volatile uint32_t s_probeCounter = 0;
+static uint32_t s_probeIdleCountPerMs = 0;
+
+static void cpu_load_probe_task(void* arg) {
+    while (true) {
+        s_probeCounter++;
+    }
+}
+
+static esp_err_t cpu_load_probe_start() {
+    // Pin the probe next to the benchmark task so it only measures the core the benchmark runs on
+    BaseType_t created = xTaskCreatePinnedToCore(cpu_load_probe_task, "cpu_probe", configMINIMAL_STACK_SIZE, NULL, tskIDLE_PRIORITY + 1, NULL, xPortGetCoreID());
+    ESP_RETURN_ON_FALSE(created == pdPASS, ESP_ERR_NO_MEM, TAG, "Could not create CPU load probe task");
+
+    uint32_t startCount = s_probeCounter;
+    vTaskDelay(ProbeCalibrationTime);
+    s_probeIdleCountPerMs = (s_probeCounter - startCount) / pdTICKS_TO_MS(ProbeCalibrationTime);
+    ESP_LOGI(TAG, "CPU load probe calibrated to %" PRIu32 " iterations per ms", s_probeIdleCountPerMs);
+    return ESP_OK;
+}
+#endif
+
+static inline int64_t benchmark_time_us() {
+#if CONFIG_IDF_TARGET_LINUX
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t) now.tv_sec * 1000000LL + now.tv_nsec / 1000;
+#else
+    return esp_timer_get_time();
+#endif
+}
+
+static esp_err_t send_frame(led_driver_max7219_handle_t handle, benchmark_api_t api, uint8_t chainLength, const uint8_t digitCodes[]) {
+    switch (api) {
+        case BENCHMARK_API_SET_DIGIT:
+            for (uint8_t chainId = 1; chainId <= chainLength; chainId++) {
+                for (uint8_t digitId = MAX7219_MIN_DIGIT; digitId <= MAX7219_MAX_DIGIT; digitId++) {
+                    ESP_RETURN_ON_ERROR(led_driver_max7219_set_digit(handle, chainId, digitId, digitCodes[(chainId - 1) * MAX7219_MAX_DIGIT + digitId - 1]), TAG, "led_driver_max7219_set_digit() failed");
+                }
+            }
+            return ESP_OK;
+
+        case BENCHMARK_API_SET_DIGITS:
+            return led_driver_max7219_set_digits(handle, 1, MAX7219_MIN_DIGIT, digitCodes, chainLength * MAX7219_MAX_DIGIT);
+
+        case BENCHMARK_API_SET_CHAIN:
+            return led_driver_max7219_set_chain(handle, digitCodes[0]);
+
+        default:
+            return ESP_ERR_INVALID_ARG;
+    }
+}
+
+static esp_err_t run_benchmark(led_driver_max7219_handle_t handle, benchmark_api_t api, uint8_t chainLength, benchmark_result_t* result) {
+    uint8_t digitCodes[UINT8_MAX];
+    uint64_t cycles = 0;
+
+#if CONFIG_IDF_TARGET_LINUX
+    spi_master_mock_reset_wire_time();
+#else
+    uint32_t startProbeCount = s_probeCounter;
+#endif
+    int64_t startUs = benchmark_time_us();
+
+    for (uint32_t frame = 0; frame < FramesPerRun; frame++) {
+        // Change every digit on every frame so each frame is a full update of the chain
+        for (uint16_t digit = 0; digit < chainLength * MAX7219_MAX_DIGIT; digit++) {
+            digitCodes[digit] = (frame + digit) % (MAX7219_CODE_B_BLANK + 1);
+        }
+
+#if CONFIG_IDF_TARGET_LINUX
+        ESP_RETURN_ON_ERROR(send_frame(handle, api, chainLength, digitCodes), TAG, "Failed to send frame");
+#else
+        uint32_t startCycles = esp_cpu_get_cycle_count();
+        ESP_RETURN_ON_ERROR(send_frame(handle, api, chainLength, digitCodes), TAG, "Failed to send frame");
+        cycles += esp_cpu_get_cycle_count() - startCycles;
+#endif
+    }
+
+    result->elapsedUs = benchmark_time_us() - startUs;
+    result->cycles = cycles;
+
+#if CONFIG_IDF_TARGET_LINUX
+    // Everything but the modelled wire time is CPU time spent in the driver
+    uint64_t wireUs = spi_master_mock_get_wire_time_us();
+    result->cpuLoadPermille = wireUs >= result->elapsedUs ? 0 : (uint32_t) (((result->elapsedUs - wireUs) * 1000) / result->elapsedUs);
+#else
+    uint64_t expectedIdleCount = (uint64_t) s_probeIdleCountPerMs * result->elapsedUs / 1000;
+    uint64_t probeCount = s_probeCounter - startProbeCount;
+    result->cpuLoadPermille = (expectedIdleCount == 0) || (probeCount >= expectedIdleCount) ? 0 : (uint32_t) (1000 - (probeCount * 1000) / expectedIdleCount);
+#endif
+
+    return ESP_OK;
+}
+
+static esp_err_t benchmark_configuration(uint8_t chainLength, int clockSpeedHz) {
+    max7219_config_t max7219InitConfig = {
+        .spi_cfg = {
+            .host_id = SPI_HOSTID,
+
+            .clock_source = SPI_CLK_SRC_DEFAULT,
+            .clock_speed_hz = clockSpeedHz,
+
+            .spics_io_num = CS_LOAD_PIN,
+            .queue_size = 8
+        },
+        .hw_config = {
+            .chain_length = chainLength
+        }
+    };
+
+    led_driver_max7219_handle_t handle = NULL;
+    ESP_RETURN_ON_ERROR(led_driver_max7219_init(&max7219InitConfig, &handle), TAG, "Failed to initialize MAX7219 / MAX7221 driver");
+
+    esp_err_t ret = ESP_OK;
+    ESP_GOTO_ON_ERROR(led_driver_max7219_configure_chain_scan_limit(handle, MAX7219_MAX_DIGIT), cleanup, TAG, "Failed to configure scan limit");
+    ESP_GOTO_ON_ERROR(led_driver_max7219_configure_chain_decode(handle, MAX7219_CODE_B_DECODE_ALL), cleanup, TAG, "Failed to configure decode mode");
+    ESP_GOTO_ON_ERROR(led_driver_max7219_set_chain_mode(handle, MAX7219_NORMAL_MODE), cleanup, TAG, "Failed to set normal mode");
+
+    for (benchmark_api_t api = 0; api < BENCHMARK_API_COUNT; api++) {
+        benchmark_result_t result = { 0 };
+        ESP_GOTO_ON_ERROR(run_benchmark(handle, api, chainLength, &result), cleanup, TAG, "Benchmark '%s' failed", BenchmarkApiNames[api]);
+
+        uint64_t framesPerSecond = (FramesPerRun * 1000000ULL) / result.elapsedUs;
+        uint64_t usPerFrame = result.elapsedUs / FramesPerRun;
+        uint64_t cyclesPerFrame = result.cycles / FramesPerRun;
+        printf("| %5u | %9d | %-10s | %10" PRIu64 " | %10" PRIu64 " | %12" PRIu64 " | %3" PRIu32 ".%" PRIu32 " %% |\n",
+               chainLength, clockSpeedHz / 1000, BenchmarkApiNames[api], framesPerSecond, usPerFrame, cyclesPerFrame,
+               result.cpuLoadPermille / 10, result.cpuLoadPermille % 10);
+    }
+
+cleanup:
+    led_driver_max7219_free(handle);
+    return ret;
+}
+
+
+
+void app_main(void) {
+    // Run above the CPU load probe so the probe only gets the CPU time the benchmark leaves
+    vTaskPrioritySet(NULL, tskIDLE_PRIORITY + 5);
+
+#if CONFIG_IDF_TARGET_LINUX
+    ESP_ERROR_CHECK(spi_master_mock_install());
+#else
+    // Configure SPI bus to communicate with MAX7219 / MAX7221
+    spi_bus_config_t spiBusConfig = {
+        .mosi_io_num = DIN_PIN,
+        .miso_io_num = GPIO_NUM_NC,
+        .sclk_io_num = CLK_PIN,
+
+        .data2_io_num = GPIO_NUM_NC,
+        .data3_io_num = GPIO_NUM_NC,
+
+        .max_transfer_sz = SOC_SPI_MAXIMUM_BUFFER_SIZE,
+        .flags = SPICOMMON_BUSFLAG_MASTER,
+        .isr_cpu_id = ESP_INTR_CPU_AFFINITY_AUTO
+    };
+    ESP_ERROR_CHECK(spi_bus_initialize(SPI_HOSTID, &spiBusConfig, SPI_DMA_CH_AUTO));
+
+    ESP_ERROR_CHECK(cpu_load_probe_start());
+#endif
+
+    ESP_LOGI(TAG, "Sending %" PRIu32 " frames per configuration - A frame updates every digit on the chain", FramesPerRun);
+    printf("| chain | clock kHz | api        |   frames/s |   us/frame | cycles/frame |   cpu   |\n");
+    printf("|-------|-----------|------------|------------|------------|--------------|---------|\n");
+
+    for (size_t chainIndex = 0; chainIndex < sizeof(ChainLengths) / sizeof(ChainLengths[0]); chainIndex++) {
+        for (size_t clockIndex = 0; clockIndex < sizeof(ClockSpeedsHz) / sizeof(ClockSpeedsHz[0]); clockIndex++) {
+            ESP_ERROR_CHECK(benchmark_configuration(ChainLengths[chainIndex], ClockSpeedsHz[clockIndex]));
+        }
+    }
+
+    ESP_LOGI(TAG, "Benchmark complete");
+
+#if !CONFIG_IDF_TARGET_LINUX
+    ESP_ERROR_CHECK(spi_bus_free(SPI_HOSTID));
+#endif
+}
@@ -0,0 +1,81 @@
+// -----------------------------------------------------------------------------------
+// Copyright 2024, Gilles Zunino
+// -----------------------------------------------------------------------------------
+
+#include <stdlib.h>
+#include <time.h>
+
+#include "Mockspi_master.h"
+
+#include "spi_master_mock.h"
+
+
+//
+// Approximate cost of one interrupt driven spi_device_transmit() on an ESP32 (queueing, /CS setup and hold, ISR and task wake up)
+// This keeps numbers from the linux target in the same ballpark as numbers measured on a chip
+//
+const uint32_t SpiMockTransactionOverheadNs = 15 * 1000;
+
+// The SPI driver only hands out opaque device handles - The mock defines its own device
+struct spi_device_t {
+    int clock_speed_hz;
+};
+
+static uint64_t s_wireTimeNs = 0;
+
+
+static uint64_t monotonic_ns_private() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+static esp_err_t spi_bus_add_device_stub(spi_host_device_t host_id, const spi_device_interface_config_t* dev_config, spi_device_handle_t* handle, int numCalls) {
+    struct spi_device_t* device = calloc(1, sizeof(struct spi_device_t));
+    if (device == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    device->clock_speed_hz = dev_config->clock_speed_hz;
+    *handle = device;
+    return ESP_OK;
+}
+
+static esp_err_t spi_bus_remove_device_stub(spi_device_handle_t handle, int numCalls) {
+    free(handle);
+    return ESP_OK;
+}
+
+static esp_err_t spi_device_acquire_bus_stub(spi_device_handle_t device, TickType_t wait, int numCalls) {
+    return ESP_OK;
+}
+
+static void spi_device_release_bus_stub(spi_device_handle_t dev, int numCalls) {
+}
+
+static esp_err_t spi_device_transmit_stub(spi_device_handle_t handle, spi_transaction_t* trans_desc, int numCalls) {
+    // Busy wait for the time the transaction would occupy the bus - The FreeRTOS linux port does not switch tasks while a thread sleeps
+    uint64_t wireNs = SpiMockTransactionOverheadNs + ((uint64_t) trans_desc->length * 1000000000ULL) / handle->clock_speed_hz;
+    uint64_t deadline = monotonic_ns_private() + wireNs;
+    while (monotonic_ns_private() < deadline) {
+    }
+    s_wireTimeNs += wireNs;
+    return ESP_OK;
+}
+
+
+esp_err_t spi_master_mock_install() {
+    spi_bus_add_device_Stub(spi_bus_add_device_stub);
+    spi_bus_remove_device_Stub(spi_bus_remove_device_stub);
+    spi_device_acquire_bus_Stub(spi_device_acquire_bus_stub);
+    spi_device_release_bus_Stub(spi_device_release_bus_stub);
+    spi_device_transmit_Stub(spi_device_transmit_stub);
+    return ESP_OK;
+}
+
+uint64_t spi_master_mock_get_wire_time_us() {
+    return s_wireTimeNs / 1000;
+}
+
+void spi_master_mock_reset_wire_time() {
+    s_wireTimeNs = 0;
+}
@@ -0,0 +1,25 @@
+// -----------------------------------------------------------------------------------
+// Copyright 2024, Gilles Zunino
+// -----------------------------------------------------------------------------------
+
+#pragma once
+
+#include <stdint.h>
+#include <esp_err.h>
+
+
+/**
+ * @brief Install CMock stubs for the SPI master driver on the linux target.
+ * @note Every transaction is delayed by the time it would take on the wire at the device clock speed plus a fixed per transaction overhead.
+ */
+esp_err_t spi_master_mock_install();
+
+/**
+ * @brief Total time, in microseconds, spent modelling SPI transfers since the last call to `spi_master_mock_reset_wire_time()`.
+ */
+uint64_t spi_master_mock_get_wire_time_us();
+
+/**
+ * @brief Reset the accumulated wire time.
+ */
+void spi_master_mock_reset_wire_time();
@@ -0,0 +1,70 @@
+#include <stddef.h>
+#include "matrix_keyboard.h"
+#include "keymap.h"
+
+#define CHAR(c, l)  { .action = KEYMAP_ACTION_CHAR, .character = (c), .led = (l) }
+#define SHIFT(l)    { .action = KEYMAP_ACTION_SHIFT, .led = (l) }
+
+// The LEDs snake through the pad, rows 1 and 3 run right to left
+#define LED(row, col)   (((row) & 1) ? (row) * KEYMAP_COLS + KEYMAP_COLS - (col) : (row) * KEYMAP_COLS + (col) + 1)
+
+// const tables stay in flash, nothing to set up at run time
+static const keymap_entry_t keymap_layers[KEYMAP_LAYER_MAX][KEYMAP_ROWS][KEYMAP_COLS] = {
+    [KEYMAP_LAYER_BASE] = {
+        {CHAR('1', LED(0, 0)), CHAR('2', LED(0, 1)), CHAR('3', LED(0, 2)), CHAR('4', LED(0, 3))},
+        {CHAR('5', LED(1, 0)), CHAR('6', LED(1, 1)), CHAR('7', LED(1, 2)), CHAR('8', LED(1, 3))},
+        {CHAR('9', LED(2, 0)), CHAR('0', LED(2, 1)), CHAR('+', LED(2, 2)), CHAR('-', LED(2, 3))},
+        {SHIFT(LED(3, 0)),     CHAR('/', LED(3, 1)), CHAR('=', LED(3, 2)), CHAR('M', LED(3, 3))},
+    },
+    // held shift turns the top row into operators
+    [KEYMAP_LAYER_SHIFT] = {
+        {CHAR('+', LED(0, 0)), CHAR('-', LED(0, 1)), CHAR('*', LED(0, 2)), CHAR('/', LED(0, 3))},
+        {CHAR('5', LED(1, 0)), CHAR('6', LED(1, 1)), CHAR('7', LED(1, 2)), CHAR('8', LED(1, 3))},
+        {CHAR('9', LED(2, 0)), CHAR('0', LED(2, 1)), CHAR('+', LED(2, 2)), CHAR('-', LED(2, 3))},
+        {SHIFT(LED(3, 0)),     CHAR('/', LED(3, 1)), CHAR('=', LED(3, 2)), CHAR('M', LED(3, 3))},
+    },
+};
+
+_Static_assert(LED(1, 0) == 8 && LED(3, 3) == 13, "LED numbering must follow the strip");
+
+static const keymap_entry_t keymap_none = { .action = KEYMAP_ACTION_NONE };
+
+// Only written and read from the keyboard event handler, an aligned pointer store is atomic anyway
+static const keymap_entry_t (*active_layer)[KEYMAP_COLS] = keymap_layers[KEYMAP_LAYER_BASE];
+
+const keymap_entry_t *keymap_lookup(uint32_t key_code)
+{
+    // the driver's rows are wired to the pad's columns
+    uint32_t row = GET_KEY_CODE_COL(key_code);
+    uint32_t col = GET_KEY_CODE_ROW(key_code);
+    if (row >= KEYMAP_ROWS || col >= KEYMAP_COLS) {
+        return &keymap_none;
+    }
+    return &active_layer[row][col];
+}
+
+void keymap_set_layer(keymap_layer_t layer)
+{
+    if (layer < KEYMAP_LAYER_MAX) {
+        active_layer = keymap_layers[layer];
+    }
+}
+
+uint8_t keymap_led_at(uint32_t row, uint32_t col)
+{
+    return LED(row, col);
+}
+
+bool keymap_led_position(uint8_t led, uint8_t *row, uint8_t *col)
+{
+    if (led < 1 || led > KEYMAP_ROWS * KEYMAP_COLS) {
+        return false;
+    }
+    // undo the snake of LED()
+    *row = (led - 1) / KEYMAP_COLS;
+    *col = (led - 1) % KEYMAP_COLS;
+    if (*row & 1) {
+        *col = KEYMAP_COLS - 1 - *col;
+    }
+    return true;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define KEYMAP_ROWS 4
+#define KEYMAP_COLS 4
+
+typedef enum {
+    KEYMAP_ACTION_NONE,         // key does nothing on this layer
+    KEYMAP_ACTION_CHAR,         // send `character` to the game
+    KEYMAP_ACTION_SHIFT,        // switch to the shift layer while held
+} keymap_action_t;
+
+typedef enum {
+    KEYMAP_LAYER_BASE,
+    KEYMAP_LAYER_SHIFT,
+    KEYMAP_LAYER_MAX,
+} keymap_layer_t;
+
+// What one key does on one layer
+typedef struct {
+    uint8_t action;             // keymap_action_t
+    char character;
+    uint8_t led;                // LED under the key, 0 for none
+} keymap_entry_t;
+
+// Entry of the key on the active layer, O(1) and safe to call from the keyboard event path.
+// Key codes outside of the keymap get an entry with KEYMAP_ACTION_NONE.
+const keymap_entry_t *keymap_lookup(uint32_t key_code);
+
+// Switch the active layer, only swaps a pointer
+void keymap_set_layer(keymap_layer_t layer);
+
+// LED under the key at `row`, `col` of the pad
+uint8_t keymap_led_at(uint32_t row, uint32_t col);
+
+// Position on the pad of the LED `led`, false if no key sits on it
+bool keymap_led_position(uint8_t led, uint8_t *row, uint8_t *col);
@@ -0,0 +1,157 @@
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "esp_console.h"
+#include "latency.h"
+
+// Log-linear histogram: exact below 32 us, then 16 buckets per power of two (at most 6% error) up to ~1 s
+#define LATENCY_SUB_BITS     4
+#define LATENCY_SUB_BUCKETS  (1 << LATENCY_SUB_BITS)
+#define LATENCY_LINEAR_MAX   (2 * LATENCY_SUB_BUCKETS)
+#define LATENCY_MAX_EXP      20
+#define LATENCY_NR_BUCKETS   (LATENCY_LINEAR_MAX + (LATENCY_MAX_EXP - LATENCY_SUB_BITS - 1) * LATENCY_SUB_BUCKETS)
+
+typedef struct {
+    uint32_t count;
+    uint32_t max_us;
+    uint32_t buckets[LATENCY_NR_BUCKETS];
+} latency_hist_t;
+
+static const char *TAG = "latency";
+
+static const char *const stage_names[LATENCY_STAGE_MAX] = {
+    [LATENCY_STAGE_DEBOUNCE] = "edge->debounced",
+    [LATENCY_STAGE_DISPATCH] = "debounced->handler",
+    [LATENCY_STAGE_LED]      = "press->led",
+    [LATENCY_STAGE_GAME]     = "press->game",
+    [LATENCY_STAGE_WAKE]     = "wake->handler",
+    [LATENCY_STAGE_EFFECTS]  = "effects frame",
+};
+
+static latency_hist_t hists[LATENCY_STAGE_MAX];
+static portMUX_TYPE hist_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static uint32_t latency_bucket(uint32_t us)
+{
+    if (us < LATENCY_LINEAR_MAX) {
+        return us;
+    }
+    uint32_t exp = 31 - __builtin_clz(us);
+    if (exp >= LATENCY_MAX_EXP) {
+        return LATENCY_NR_BUCKETS - 1;
+    }
+    uint32_t sub = (us >> (exp - LATENCY_SUB_BITS)) & (LATENCY_SUB_BUCKETS - 1);
+    return LATENCY_LINEAR_MAX + (exp - LATENCY_SUB_BITS - 1) * LATENCY_SUB_BUCKETS + sub;
+}
+
+// Upper bound of the values falling into a bucket
+static uint32_t latency_bucket_limit(uint32_t bucket)
+{
+    if (bucket < LATENCY_LINEAR_MAX) {
+        return bucket;
+    }
+    uint32_t exp = (bucket - LATENCY_LINEAR_MAX) / LATENCY_SUB_BUCKETS + LATENCY_SUB_BITS + 1;
+    uint32_t sub = (bucket - LATENCY_LINEAR_MAX) % LATENCY_SUB_BUCKETS;
+    return ((LATENCY_SUB_BUCKETS + sub + 1) << (exp - LATENCY_SUB_BITS)) - 1;
+}
+
+static uint32_t latency_percentile(const latency_hist_t *hist, uint32_t percent)
+{
+    uint32_t rank = (hist->count * percent + 99) / 100;
+    uint32_t seen = 0;
+    for (uint32_t i = 0; i < LATENCY_NR_BUCKETS; i++) {
+        seen += hist->buckets[i];
+        if (seen >= rank) {
+            uint32_t limit = latency_bucket_limit(i);
+            return limit < hist->max_us ? limit : hist->max_us;
+        }
+    }
+    return hist->max_us;
+}
+
+void latency_record(latency_stage_t stage, int64_t start_us, int64_t end_us)
+{
+    if (stage >= LATENCY_STAGE_MAX || end_us < start_us) {
+        return;
+    }
+    uint32_t us = end_us - start_us > UINT32_MAX ? UINT32_MAX : end_us - start_us;
+    latency_hist_t *hist = &hists[stage];
+
+    portENTER_CRITICAL(&hist_lock);
+    hist->buckets[latency_bucket(us)]++;
+    hist->count++;
+    if (us > hist->max_us) {
+        hist->max_us = us;
+    }
+    portEXIT_CRITICAL(&hist_lock);
+}
+
+void latency_dump(void)
+{
+    static latency_hist_t copy;
+    printf("%-20s %8s %8s %8s %8s\n", "stage (us)", "count", "p50", "p99", "max");
+    for (int stage = 0; stage < LATENCY_STAGE_MAX; stage++) {
+        portENTER_CRITICAL(&hist_lock);
+        copy = hists[stage];
+        portEXIT_CRITICAL(&hist_lock);
+        if (!copy.count) {
+            printf("%-20s %8d %8s %8s %8s\n", stage_names[stage], 0, "-", "-", "-");
+            continue;
+        }
+        printf("%-20s %8"PRIu32" %8"PRIu32" %8"PRIu32" %8"PRIu32"\n", stage_names[stage], copy.count,
+               latency_percentile(&copy, 50), latency_percentile(&copy, 99), copy.max_us);
+    }
+}
+
+void latency_reset(void)
+{
+    portENTER_CRITICAL(&hist_lock);
+    memset(hists, 0, sizeof(hists));
+    portEXIT_CRITICAL(&hist_lock);
+}
+
+static int latency_cmd(int argc, char **argv)
+{
+    if (argc > 1 && strcmp(argv[1], "reset") == 0) {
+        latency_reset();
+        return 0;
+    }
+    latency_dump();
+    return 0;
+}
+
+esp_err_t latency_console_init(void)
+{
+    esp_console_repl_t *repl = NULL;
+    esp_console_repl_config_t repl_config = ESP_CONSOLE_REPL_CONFIG_DEFAULT();
+    repl_config.prompt = "toya>";
+    esp_err_t err;
+
+#if CONFIG_ESP_CONSOLE_UART_DEFAULT || CONFIG_ESP_CONSOLE_UART_CUSTOM
+    esp_console_dev_uart_config_t hw_config = ESP_CONSOLE_DEV_UART_CONFIG_DEFAULT();
+    err = esp_console_new_repl_uart(&hw_config, &repl_config, &repl);
+#elif CONFIG_ESP_CONSOLE_USB_CDC
+    esp_console_dev_usb_cdc_config_t hw_config = ESP_CONSOLE_DEV_CDC_CONFIG_DEFAULT();
+    err = esp_console_new_repl_usb_cdc(&hw_config, &repl_config, &repl);
+#else
+    err = ESP_ERR_NOT_SUPPORTED;
+#endif
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "create console REPL failed: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    const esp_console_cmd_t cmd = {
+        .command = "latency",
+        .help = "Print p50/p99/max key press latency per stage, `latency reset` clears the histograms",
+        .func = latency_cmd,
+    };
+    err = esp_console_cmd_register(&cmd);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "register console command failed: %s", esp_err_to_name(err));
+        return err;
+    }
+    return esp_console_start_repl(repl);
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+
+// Stages of a key press, from the electrical edge to the feedback the player sees
+typedef enum {
+    LATENCY_STAGE_DEBOUNCE,     // row edge interrupt -> debounced key down
+    LATENCY_STAGE_DISPATCH,     // debounced key down -> kbd_handler
+    LATENCY_STAGE_LED,          // key press -> LED frame on the wire
+    LATENCY_STAGE_GAME,         // key press -> game task xQueueReceive
+    LATENCY_STAGE_WAKE,         // row interrupt after a light sleep wake up -> kbd_handler
+    LATENCY_STAGE_EFFECTS,      // time to advance and render one LED effects frame
+    LATENCY_STAGE_MAX,
+} latency_stage_t;
+
+// Record one sample of a stage, `start_us` and `end_us` come from esp_timer_get_time()
+void latency_record(latency_stage_t stage, int64_t start_us, int64_t end_us);
+
+// Print p50/p99/max of every stage
+void latency_dump(void);
+
+void latency_reset(void);
+
+// Register the `latency` console command and start the console REPL
+esp_err_t latency_console_init(void);
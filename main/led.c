@@ -1,80 +1,109 @@
-#include <driver/rmt.h>
-#include <driver/gpio.h>
-#include <stdint.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "led_strip.h"
+#include "led.h"
+#include "latency.h"
 
-// WS2812 timing parameters (in nanoseconds)
-#define WS2812_T0H    350    // 0 bit high time
-#define WS2812_T0L    900    // 0 bit low time
-#define WS2812_T1H    900    // 1 bit high time
-#define WS2812_T1L    350    // 1 bit low time
+// 10MHz resolution, 1 tick = 0.1us, enough for the WS2812 bit timing
+#define LED_RMT_RES_HZ  (10 * 1000 * 1000)
 
-// Configure these as needed
-#define RMT_TX_CHANNEL    RMT_CHANNEL_0
-#define LED_PIN           GPIO_NUM_14
-#define MAX_LEDS         30
+static const char *TAG = "led";
 
+static led_strip_handle_t strip;
+static TaskHandle_t led_task_handle;
 
-// Initialize RMT peripheral for WS2812
-esp_err_t ws2812_init(void) {
-    rmt_config_t config = {
-        .rmt_mode = RMT_MODE_TX,
-        .channel = RMT_TX_CHANNEL,
-        .gpio_num = LED_PIN,
-        .clk_div = 2, // 40MHz => 25ns resolution
-        .mem_block_num = 1,
-        .tx_config = {
-            .carrier_freq_hz = 0,
-            .carrier_level = RMT_CARRIER_LEVEL_LOW,
-            .idle_level = RMT_IDLE_LEVEL_LOW,
-            .carrier_duty_percent = 50,
-            .carrier_en = false,
-            .loop_en = false,
-            .idle_output_en = true,
-        }
-    };
+// Staged frame, written by led_set_pixel() and copied out by the LED task under frame_lock
+static led_strip_rgb_t frame[MAX_LEDS];
+static int64_t frame_request_us;
+static portMUX_TYPE frame_lock = portMUX_INITIALIZER_UNLOCKED;
 
-    esp_err_t ret = rmt_config(&config);
-    if (ret != ESP_OK) return ret;
+static void led_task(void *arg)
+{
+    led_strip_rgb_t pixels[MAX_LEDS];
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        portENTER_CRITICAL(&frame_lock);
+        memcpy(pixels, frame, sizeof(pixels));
+        int64_t request_us = frame_request_us;
+        frame_request_us = 0;
+        portEXIT_CRITICAL(&frame_lock);
 
-    return rmt_driver_install(config.channel, 0, 0);
+        // led_strip_set_pixels() only fills the strip buffer, the refresh sends the whole chain at once
+        led_strip_stats_t before = {0}, after = {0};
+        led_strip_get_stats(strip, &before);
+        esp_err_t err = led_strip_set_pixels(strip, 0, MAX_LEDS, pixels);
+        if (err == ESP_OK) {
+            err = led_strip_refresh(strip);
+        }
+        led_strip_get_stats(strip, &after);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "frame not sent: %s", esp_err_to_name(err));
+        } else if (request_us && after.refreshes != before.refreshes) {
+            // a frame equal to the one shown is skipped, nothing went on the wire to time
+            latency_record(LATENCY_STAGE_LED, request_us, esp_timer_get_time());
+        }
+    }
 }
 
-// Convert a single byte to RMT pulses (8 bits)
-void ws2812_byte_to_rmt(uint8_t value, rmt_item32_t* items) {
-    for (int i = 0; i < 8; i++) {
-        if (value & (1 << (7 - i))) {
-            // One bit
-            items[i].level0 = 1;
-            items[i].duration0 = WS2812_T1H / 25; // Convert ns to RMT ticks
-            items[i].level1 = 0;
-            items[i].duration1 = WS2812_T1L / 25;
-        } else {
-            // Zero bit
-            items[i].level0 = 1;
-            items[i].duration0 = WS2812_T0H / 25;
-            items[i].level1 = 0;
-            items[i].duration1 = WS2812_T0L / 25;
-        }
+esp_err_t led_init(void)
+{
+    led_strip_config_t strip_config = {
+        .strip_gpio_num = LED_GPIO,
+        .max_leds = MAX_LEDS,
+        .led_model = LED_MODEL_WS2812,
+        .color_component_format = LED_STRIP_COLOR_COMPONENT_FMT_GRB,
+    };
+    led_strip_rmt_config_t rmt_config = {
+        .clk_src = RMT_CLK_SRC_DEFAULT,
+        .resolution_hz = LED_RMT_RES_HZ,
+    };
+    esp_err_t err = led_strip_new_rmt_device(&strip_config, &rmt_config, &strip);
+    if (err != ESP_OK) {
+        return err;
     }
+    if (xTaskCreate(led_task, "led", 2048, NULL, 5, &led_task_handle) != pdPASS) {
+        led_strip_del(strip);
+        return ESP_ERR_NO_MEM;
+    }
+    // the chain keeps whatever it showed before a reset
+    led_show(0);
+    return ESP_OK;
 }
 
-// Set RGB value for LED at specified index
-esp_err_t ws2812_set_led(size_t index, int r, int g, int b) {
+esp_err_t led_set_pixel(uint32_t index, uint8_t red, uint8_t green, uint8_t blue)
+{
     if (index >= MAX_LEDS) {
         return ESP_ERR_INVALID_ARG;
     }
+    portENTER_CRITICAL(&frame_lock);
+    frame[index] = (led_strip_rgb_t) {
+        .red = red, .green = green, .blue = blue,
+    };
+    portEXIT_CRITICAL(&frame_lock);
+    return ESP_OK;
+}
 
-    rmt_item32_t led_data[24];
-    
-    // Convert RGB to GRB (WS2812 format)
-    // Fill first 8 items with green data
-    ws2812_byte_to_rmt(g, &led_data[0]);
-    
-    // Fill next 8 items with red data
-    ws2812_byte_to_rmt(r, &led_data[8]);
-    
-    // Fill last 8 items with blue data
-    ws2812_byte_to_rmt(b, &led_data[16]);
+void led_clear(void)
+{
+    portENTER_CRITICAL(&frame_lock);
+    memset(frame, 0, sizeof(frame));
+    portEXIT_CRITICAL(&frame_lock);
+}
 
-    return rmt_write_items(RMT_TX_CHANNEL, led_data, 24, true);
-}
\ No newline at end of file
+void led_show(int64_t request_time_us)
+{
+    // nothing to wake when led_init() failed, the keyboard still works without the LEDs
+    if (!led_task_handle) {
+        return;
+    }
+    portENTER_CRITICAL(&frame_lock);
+    // a merged frame is late for the oldest request
+    if (!frame_request_us) {
+        frame_request_us = request_time_us;
+    }
+    portEXIT_CRITICAL(&frame_lock);
+    xTaskNotifyGive(led_task_handle);
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+
+// WS2812 chain under the keys, see keymap.c for which LED sits under which key
+#define LED_GPIO        14
+#define MAX_LEDS        30
+
+// Create the strip and the task which pushes frames to it
+esp_err_t led_init(void);
+
+// Stage one pixel of the next frame. Never blocks, safe to call from the keyboard event path.
+esp_err_t led_set_pixel(uint32_t index, uint8_t red, uint8_t green, uint8_t blue);
+
+// Stage a frame with every LED off
+void led_clear(void);
+
+// Send the staged frame to the strip, the whole chain goes out in one transfer from the LED task.
+// Frames shown again before the task gets to them are merged. `request_time_us` is recorded as
+// the start of LATENCY_STAGE_LED once the frame is on the wire, 0 to not record it. A frame equal to
+// the one already shown is not sent, and not recorded either.
+// Does nothing when led_init() failed.
+void led_show(int64_t request_time_us);
@@ -0,0 +1,264 @@
+#include <stdbool.h>
+#include <stdlib.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "led.h"
+#include "led_effects.h"
+#include "keymap.h"
+#include "latency.h"
+
+#define Q16_ONE             0x10000
+#define Q16(x)              ((uint32_t)((x) * Q16_ONE))
+#define Q8(x)               ((int32_t)((x) * 256))
+
+// Per frame multipliers of the decaying levels
+#define GLOW_DECAY          Q16(0.80)   // released key, ~400 ms to dark
+#define RIPPLE_DECAY        Q16(0.90)
+#define FLASH_DECAY         Q16(0.85)
+// Levels below this are dark once scaled to 8 bits
+#define LEVEL_MIN           (Q16_ONE / 256)
+
+#define RIPPLE_SPEED        Q8(0.25)    // key pitches per frame
+#define RIPPLE_WIDTH        Q8(1.0)     // the ring fades out linearly over one key pitch on each side
+#define MAX_RIPPLES         4
+
+typedef struct {
+    uint8_t r, g, b;
+} color_t;
+
+// Peak colors, kept as dim as the old fixed 50,50,50
+static const color_t glow_color = {50, 50, 50};
+static const color_t ripple_color = {0, 20, 60};
+static const color_t flash_colors[] = {
+    [LED_EFFECTS_FLASH_CORRECT]   = {0, 60, 0},
+    [LED_EFFECTS_FLASH_INCORRECT] = {60, 0, 0},
+};
+static const uint8_t flash_pulses[] = {
+    [LED_EFFECTS_FLASH_CORRECT]   = 1,
+    [LED_EFFECTS_FLASH_INCORRECT] = 2,
+};
+
+// Distance between two keys of the pad, indexed by the row and column differences, Q8
+static const int32_t key_distance[KEYMAP_ROWS][KEYMAP_COLS] = {
+    {0,   256, 512, 768},
+    {256, 362, 572, 810},
+    {512, 572, 724, 923},
+    {768, 810, 923, 1086},
+};
+
+typedef struct {
+    uint8_t row, col;
+    int32_t radius;             // Q8
+    uint32_t level;             // Q16, 0 when the slot is free
+} ripple_t;
+
+typedef struct {
+    uint32_t glow[KEYMAP_ROWS][KEYMAP_COLS];    // Q16
+    uint32_t held;                              // bit row * KEYMAP_COLS + col
+    ripple_t ripples[MAX_RIPPLES];
+    led_effects_flash_t flash;
+    uint32_t flash_level;                       // Q16
+    uint8_t flash_pulses;                       // pulses left after the current one
+} effects_t;
+
+static const char *TAG = "effects";
+
+static effects_t effects;
+static bool timer_running;
+static portMUX_TYPE effects_lock = portMUX_INITIALIZER_UNLOCKED;
+static esp_timer_handle_t frame_timer;
+
+static uint32_t q16_mul(uint32_t a, uint32_t b)
+{
+    return ((uint64_t)a * b) >> 16;
+}
+
+// Level of a ripple ring at a key, Q16
+static uint32_t ripple_level_at(const ripple_t *ripple, int row, int col)
+{
+    int32_t distance = key_distance[abs(row - ripple->row)][abs(col - ripple->col)];
+    int32_t off_ring = abs(distance - ripple->radius);
+    if (off_ring >= RIPPLE_WIDTH) {
+        return 0;
+    }
+    // RIPPLE_WIDTH is one Q8 unit, (width - off) / width in Q16 is a shift
+    return q16_mul(ripple->level, (uint32_t)(RIPPLE_WIDTH - off_ring) << 8);
+}
+
+static void add_color(uint32_t *acc, color_t color, uint32_t level)
+{
+    acc[0] += color.r * level;
+    acc[1] += color.g * level;
+    acc[2] += color.b * level;
+}
+
+// Called with effects_lock held
+static void render(uint8_t pixels[KEYMAP_ROWS][KEYMAP_COLS][3])
+{
+    for (int row = 0; row < KEYMAP_ROWS; row++) {
+        for (int col = 0; col < KEYMAP_COLS; col++) {
+            uint32_t acc[3] = {0};   // 8 bit color times Q16 level
+            add_color(acc, glow_color, effects.glow[row][col]);
+            for (int i = 0; i < MAX_RIPPLES; i++) {
+                if (effects.ripples[i].level) {
+                    add_color(acc, ripple_color, ripple_level_at(&effects.ripples[i], row, col));
+                }
+            }
+            add_color(acc, flash_colors[effects.flash], effects.flash_level);
+            for (int c = 0; c < 3; c++) {
+                uint32_t value = acc[c] >> 16;
+                pixels[row][col][c] = value > 255 ? 255 : value;
+            }
+        }
+    }
+}
+
+static uint32_t decay(uint32_t level, uint32_t factor)
+{
+    level = q16_mul(level, factor);
+    return level < LEVEL_MIN ? 0 : level;
+}
+
+// Move every effect one frame on, called with effects_lock held. Returns whether anything still moves.
+static bool advance(void)
+{
+    bool moving = false;
+    for (int row = 0; row < KEYMAP_ROWS; row++) {
+        for (int col = 0; col < KEYMAP_COLS; col++) {
+            if (!(effects.held & (1u << (row * KEYMAP_COLS + col))) && effects.glow[row][col]) {
+                effects.glow[row][col] = decay(effects.glow[row][col], GLOW_DECAY);
+                moving |= effects.glow[row][col] != 0;
+            }
+        }
+    }
+    for (int i = 0; i < MAX_RIPPLES; i++) {
+        ripple_t *ripple = &effects.ripples[i];
+        if (!ripple->level) {
+            continue;
+        }
+        ripple->radius += RIPPLE_SPEED;
+        ripple->level = decay(ripple->level, RIPPLE_DECAY);
+        // gone once the ring is past the farthest key
+        if (ripple->radius >= key_distance[KEYMAP_ROWS - 1][KEYMAP_COLS - 1] + RIPPLE_WIDTH) {
+            ripple->level = 0;
+        }
+        moving |= ripple->level != 0;
+    }
+    if (effects.flash_level) {
+        effects.flash_level = decay(effects.flash_level, FLASH_DECAY);
+        if (effects.flash_level < Q16(0.1) && effects.flash_pulses) {
+            effects.flash_pulses--;
+            effects.flash_level = Q16_ONE;
+        }
+        moving |= effects.flash_level != 0;
+    }
+    return moving;
+}
+
+static void show(const uint8_t pixels[KEYMAP_ROWS][KEYMAP_COLS][3], int64_t request_time_us)
+{
+    for (int row = 0; row < KEYMAP_ROWS; row++) {
+        for (int col = 0; col < KEYMAP_COLS; col++) {
+            led_set_pixel(keymap_led_at(row, col), pixels[row][col][0], pixels[row][col][1], pixels[row][col][2]);
+        }
+    }
+    led_show(request_time_us);
+}
+
+static void frame_cb(void *arg)
+{
+    uint8_t pixels[KEYMAP_ROWS][KEYMAP_COLS][3];
+    int64_t start_us = esp_timer_get_time();
+    portENTER_CRITICAL(&effects_lock);
+    bool moving = advance();
+    render(pixels);
+    // the last frame is the one where everything came to rest, nothing to draw until the next trigger
+    if (!moving) {
+        esp_timer_stop(frame_timer);
+        timer_running = false;
+    }
+    portEXIT_CRITICAL(&effects_lock);
+    latency_record(LATENCY_STAGE_EFFECTS, start_us, esp_timer_get_time());
+    show(pixels, 0);
+}
+
+// Called with effects_lock held. Without a frame timer (led_effects_init() failed or never ran)
+// the state still advances, it just never gets animated.
+static void start_frames(void)
+{
+    if (!timer_running && frame_timer) {
+        esp_timer_start_periodic(frame_timer, LED_EFFECTS_FRAME_MS * 1000);
+        timer_running = true;
+    }
+}
+
+esp_err_t led_effects_init(void)
+{
+    const esp_timer_create_args_t timer_args = {
+        .callback = frame_cb,
+        .name = "led_effects",
+        // a late frame can simply be skipped
+        .skip_unhandled_events = true,
+    };
+    esp_err_t err = esp_timer_create(&timer_args, &frame_timer);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "create frame timer failed: %s", esp_err_to_name(err));
+    }
+    return err;
+}
+
+void led_effects_key_down(uint8_t led, int64_t press_time_us)
+{
+    uint8_t row, col;
+    uint8_t pixels[KEYMAP_ROWS][KEYMAP_COLS][3];
+    if (!keymap_led_position(led, &row, &col)) {
+        return;
+    }
+    portENTER_CRITICAL(&effects_lock);
+    effects.held |= 1u << (row * KEYMAP_COLS + col);
+    effects.glow[row][col] = Q16_ONE;
+    // take a free slot, or the faintest ripple
+    ripple_t *ripple = &effects.ripples[0];
+    for (int i = 1; i < MAX_RIPPLES; i++) {
+        if (effects.ripples[i].level < ripple->level) {
+            ripple = &effects.ripples[i];
+        }
+    }
+    *ripple = (ripple_t) {
+        .row = row,
+        .col = col,
+        .radius = 0,
+        .level = Q16_ONE,
+    };
+    start_frames();
+    // the key lights up now rather than on the next tick
+    render(pixels);
+    portEXIT_CRITICAL(&effects_lock);
+    show(pixels, press_time_us);
+}
+
+void led_effects_key_up(uint8_t led)
+{
+    uint8_t row, col;
+    if (!keymap_led_position(led, &row, &col)) {
+        return;
+    }
+    portENTER_CRITICAL(&effects_lock);
+    effects.held &= ~(1u << (row * KEYMAP_COLS + col));
+    start_frames();
+    portEXIT_CRITICAL(&effects_lock);
+}
+
+void led_effects_flash(led_effects_flash_t flash)
+{
+    if (flash >= sizeof(flash_pulses) / sizeof(flash_pulses[0])) {
+        return;
+    }
+    portENTER_CRITICAL(&effects_lock);
+    effects.flash = flash;
+    effects.flash_level = Q16_ONE;
+    effects.flash_pulses = flash_pulses[flash] - 1;
+    start_frames();
+    portEXIT_CRITICAL(&effects_lock);
+}
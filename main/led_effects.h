@@ -0,0 +1,29 @@
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+
+// 50 frames per second, a frame is rendered into the LED framebuffer on every tick of a periodic esp_timer.
+// The timer only runs while something moves, a held key at full brightness or a dark pad cost nothing.
+//
+// Rendering a frame is all integer math on 16 LEDs: levels are Q16 (0x10000 is full), distances on the
+// pad are Q8 fractions of a key pitch. Each frame is timed into LATENCY_STAGE_EFFECTS, see `latency`
+// on the console; the budget is 1 ms of the 20 ms frame, so the esp_timer task is never held up.
+#define LED_EFFECTS_FRAME_MS    20
+
+typedef enum {
+    LED_EFFECTS_FLASH_CORRECT,      // one green pulse over the whole pad
+    LED_EFFECTS_FLASH_INCORRECT,    // two red pulses
+} led_effects_flash_t;
+
+// Create the frame timer, led_init() must have been called
+esp_err_t led_effects_init(void);
+
+// Light the key under `led` at once and send a ripple out of it. The frame is rendered and shown
+// before returning, `press_time_us` starts the LATENCY_STAGE_LED sample of that frame (0 for none).
+void led_effects_key_down(uint8_t led, int64_t press_time_us);
+
+// Fade the key under `led` out
+void led_effects_key_up(uint8_t led);
+
+void led_effects_flash(led_effects_flash_t flash);
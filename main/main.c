@@ -8,12 +8,18 @@
 #include "driver/i2s.h"
 #include "esp_mac.h"
 #include "esp_spiffs.h"
+#include "esp_timer.h"
+#include "esp_pm.h"
+#include "esp_console.h"
 
 #include "esp_random.h"
 #include "esp_system.h"
 #include "string.h"
 #include "main.h"
-#include "led.c"
+#include "latency.h"
+#include "keymap.h"
+#include "led.h"
+#include "led_effects.h"
 
 int num1, num2, correct_answer;
 char operator;
@@ -33,6 +39,15 @@ bool game_active = true;
 #define HOST SPI2_HOST
 
 int display_buffer[4] = {0};
+static TaskHandle_t display_task;
+
+// Redraw the display once, the display task sleeps until then
+static void display_refresh(void)
+{
+    if (display_task) {
+        xTaskNotifyGive(display_task);
+    }
+}
 
 static const uint64_t symbols[] = {
     0x3c66666e76663c00, //0
@@ -81,6 +96,8 @@ void task(void *pvParameter)
 //     display_buffer[3]  = correct_answer;
     while (1)
     {   
+        // only wake up when the question changed, so the system can stay in light sleep
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
         for(int i = 0; i < CONFIG_EXAMPLE_CASCADE_SIZE; i++){
             max7219_draw_image_8x8(&dev, i * 8, (uint8_t *)&symbols[display_buffer[i]]);
             vTaskDelay(pdMS_TO_TICKS(CONFIG_EXAMPLE_SCROLL_DELAY));
@@ -180,7 +197,7 @@ int generate_random(int min, int max) {
 // Math game task
 void math_game_task(void *pvParameters) {
     
-    keyboard_queue = xQueueCreate(10, sizeof(char));
+    keyboard_queue = xQueueCreate(10, sizeof(key_press_t));
 
     // Generate initial question
     generate_new_question(&num1, &num2, &operator, &correct_answer);
@@ -193,7 +210,10 @@ void math_game_task(void *pvParameters) {
         bool question_active = true;
         while(question_active) {
             // Wait for character from keyboard queue
-            if(xQueueReceive(keyboard_queue, &received_char, portMAX_DELAY) == pdTRUE) {
+            key_press_t press;
+            if(xQueueReceive(keyboard_queue, &press, portMAX_DELAY) == pdTRUE) {
+                latency_record(LATENCY_STAGE_GAME, press.press_time_us, esp_timer_get_time());
+                received_char = press.key;
                 if(received_char == 'M') {
                     generate_new_question(&num1, &num2, &operator, &correct_answer);
                     printf("new question is generated");
@@ -202,11 +222,13 @@ void math_game_task(void *pvParameters) {
                 
                 if(user_answer == correct_answer) {
                     printf("\nCorrect! Well done!\n");
+                    led_effects_flash(LED_EFFECTS_FLASH_CORRECT);
                     // Generate new question only after correct answer
                     generate_new_question(&num1, &num2, &operator, &correct_answer);
                     question_active = false;
                 } else {
                     printf("\nIncorrect. Try again!\n");
+                    led_effects_flash(LED_EFFECTS_FLASH_INCORRECT);
                 }
                 
                 // Small delay for readability
@@ -230,6 +252,7 @@ static void generate_new_question(int *num1, int *num2, char *operator, int *cor
         // display_buffer[1] =  12;
         display_buffer[2] = *num2;
         display_buffer[3]  = 0;
+        display_refresh();
     } while (*correct_answer > 9 && *correct_answer < 0); // Ensure single-digit and positive answers
     
 }
@@ -262,79 +285,126 @@ static char generate_operator(void) {
 }
 
 
-int get_led_index(int row, int col){
-    return led_index[row][col];
-}
-
-
-
-void led_task(){
-    esp_err_t err = ws2812_init();
-    if(err) ESP_LOGE("errr", "err");
-
-
-    ESP_LOGI(TAG, "Start blinking LED strip");
-    // while (1) {
-    // if(Current_LED_INDEX > 0){
-    // ws2812_set_led(Current_LED_INDEX, 50, 50, 50);  // Set first LED
-    // ESP_LOGI("LED", "LED-%d ON", Current_LED_INDEX);
-    // }
-    // vTaskDelay(pdMS_TO_TICKS(500));
-    // }
-}
-
-
-
-
 char kbd_handler(matrix_kbd_handle_t mkbd_handle, matrix_kbd_event_id_t event, void *event_data, void *handler_args)
 {   
 
-    uint32_t key_code = (uint32_t)event_data;
-    int col = key_code >> 8;    // Get first 2 digits (01)
-    int row = key_code & 0xFF;  // Get last 2 digits (04)
+    int64_t handler_time_us = esp_timer_get_time();
+    const matrix_kbd_event_data_t *data = (const matrix_kbd_event_data_t *)event_data;
+    const keymap_entry_t *key = keymap_lookup(data->key_code);
+    // measure from the electrical edge when the driver captured it, otherwise from the scan which saw the key
+    int64_t press_time_us = data->edge_time_us ? data->edge_time_us : data->timestamp_us;
 
     
     switch (event) {
     case MATRIX_KBD_EVENT_DOWN:
-        Current_LED_INDEX = get_led_index(row, col);
-        ESP_LOGI(TAG, " press : %c %d %d, LED-%d",character[row][col], col, row, Current_LED_INDEX);
-        ws2812_set_led(Current_LED_INDEX, 50, 50, 50);  // Set first LED
-        xQueueSend(keyboard_queue, &character[row][col], portMAX_DELAY);
+        if (data->edge_time_us) {
+            latency_record(LATENCY_STAGE_DEBOUNCE, data->edge_time_us, data->timestamp_us);
+        }
+        latency_record(LATENCY_STAGE_DISPATCH, data->timestamp_us, handler_time_us);
+        if (data->woke_up) {
+            // this press woke the chip up, the row interrupt is the first thing to run after resume
+            latency_record(LATENCY_STAGE_WAKE, data->edge_time_us, handler_time_us);
+        }
+        ESP_LOGI(TAG, " press : %c key code %04"PRIx32", LED-%d", key->character ? key->character : ' ', data->key_code, key->led);
+        led_effects_key_down(key->led, press_time_us);
+        if (key->action == KEYMAP_ACTION_SHIFT) {
+            keymap_set_layer(KEYMAP_LAYER_SHIFT);
+        } else if (key->action == KEYMAP_ACTION_CHAR) {
+            key_press_t press = {
+                .key = key->character,
+                .press_time_us = press_time_us,
+            };
+            xQueueSend(keyboard_queue, &press, portMAX_DELAY);
+        }
         break;
     case MATRIX_KBD_EVENT_UP:
-        ws2812_set_led(Current_LED_INDEX, 0, 0, 0);  // Set first LED
-        Current_LED_INDEX = 0;
+        if (key->action == KEYMAP_ACTION_SHIFT) {
+            keymap_set_layer(KEYMAP_LAYER_BASE);
+        }
+        led_effects_key_up(key->led);
         // ESP_LOGI("IDK", "%s", xTaskGetCurrentTaskHandle());
-        // ESP_LOGI(TAG, "release event,key %c, key code = %04"PRIx32,character[row][col], key_code);
+        break;
+    default:
         break;
     }
 
-    return character[row][col];
+    return key->character;
 }
 
 static void keyboard_init(){
+    static const int row_gpios[] = {2, 1, 3, 5};
+    static const int col_gpios[] = {7, 9, 11, 12};
     matrix_kbd_handle_t kbd = NULL;
     matrix_kbd_config_t config = MATRIX_KEYBOARD_DEFAULT_CONFIG();
  
-    config.row_gpios = ROW_GPIO;
-    config.nr_col_gpios = 4;
-    config.col_gpios = COL_GPIO;
-    config.nr_row_gpios = 4;
+    config.row_gpios = row_gpios;
+    config.nr_col_gpios = KEYMAP_ROWS;
+    config.col_gpios = col_gpios;
+    config.nr_row_gpios = KEYMAP_COLS;
+#if CONFIG_KEYPAD_LIGHT_SLEEP
+    config.light_sleep_wakeup = true;
+#endif
     matrix_kbd_install(&config, &kbd);
-    matrix_kbd_register_event_handler(kbd, kbd_handler, NULL);
+    // the game only cares about presses and releases, other events never leave the scan tick
+    matrix_kbd_add_listener(kbd, MATRIX_KBD_EVENT_MASK(MATRIX_KBD_EVENT_DOWN) | MATRIX_KBD_EVENT_MASK(MATRIX_KBD_EVENT_UP),
+                            kbd_handler, NULL);
     matrix_kbd_start(kbd);
 }
 
 // play_sound(0)
 
 
+#if CONFIG_PM_ENABLE
+static int pm_cmd(int argc, char **argv)
+{
+    // time spent in each mode, including light sleep, needs CONFIG_PM_PROFILING
+    esp_pm_dump_locks(stdout);
+    return 0;
+}
+
+static void power_init(void)
+{
+    // scale down to XTAL while idle, light sleep is opt-in because it drops the USB CDC console
+    esp_pm_config_t pm_config = {
+        .max_freq_mhz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ,
+        .min_freq_mhz = 40,
+#if CONFIG_KEYPAD_LIGHT_SLEEP
+        .light_sleep_enable = true,
+#endif
+    };
+    esp_err_t err = esp_pm_configure(&pm_config);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "configure power management failed: %s", esp_err_to_name(err));
+    }
+}
+#endif
+
 void app_main(void)
 {   
+#if CONFIG_PM_ENABLE
+    power_init();
+#endif
     // ESP_ERROR_CHECK(init_spiffs());
     // ESP_ERROR_CHECK(init_i2s());
+    esp_err_t err = led_init();
+    if (err == ESP_OK) {
+        err = led_effects_init();
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "LED init failed: %s", esp_err_to_name(err));
+    }
     keyboard_init();
-    led_task();
-    xTaskCreate(task, "task", configMINIMAL_STACK_SIZE * 3, NULL, 5, NULL);
+    latency_console_init();
+#if CONFIG_PM_ENABLE
+    const esp_console_cmd_t pm_command = {
+        .command = "pm",
+        .help = "Print power management locks and time spent in each power mode",
+        .func = pm_cmd,
+    };
+    esp_console_cmd_register(&pm_command);
+#endif
+    xTaskCreate(task, "task", configMINIMAL_STACK_SIZE * 3, NULL, 5, &display_task);
+    display_refresh();
 
     xTaskCreate(math_game_task, "game_task", 2048, NULL, 5, NULL);
 }